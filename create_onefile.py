@@ -1,6 +1,8 @@
 import os 
 script_path = os.path.dirname(os.path.realpath(__file__))
 
+included = set() # headers are expanded only once as they all have #pragma once
+
 def load_cpp_with_include_expansion(fname) :
 	res = ""
 	with open(script_path + "/" + fname) as f:
@@ -12,7 +14,10 @@ def load_cpp_with_include_expansion(fname) :
 				for base in ['.', os.path.dirname(fname)] :
 					cur_header_name = base + '/' + header_name
 					if os.path.isfile(cur_header_name) :
-						res += load_cpp_with_include_expansion(cur_header_name) + "\n"
+						cur_header_name = os.path.normpath(cur_header_name)
+						if cur_header_name not in included :
+							included.add(cur_header_name)
+							res += load_cpp_with_include_expansion(cur_header_name) + "\n"
 						ok = True
 						break
 				if not ok :
@@ -0,0 +1,114 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace quick_floyd_warshall {
+namespace storage {
+
+/*
+	A file mapped into memory with mmap(MAP_SHARED), so that the OS pages it in and writes it back on demand
+	and the mapped size is only limited by the address space and the disk, not by the memory.
+	prefetch() and release() give hints for the ranges that will be used soon / are no longer needed,
+	which lets a caller walking the file in a known order keep only a bounded part of it in memory
+*/
+class mapped_file {
+public:
+	mapped_file () = default;
+	mapped_file (const mapped_file &) = delete;
+	mapped_file &operator = (const mapped_file &) = delete;
+	~mapped_file () { close(); }
+
+	/*
+		Maps size bytes of the file at path; the file is created if it doesn't exist and resized to size.
+		If truncate, the existing content is discarded(the file reads as zeros).
+		Returns false on failure, leaving nothing mapped
+	*/
+	bool open(const std::string &path, size_t size, bool truncate) {
+		close();
+		fd = ::open(path.c_str(), O_RDWR | O_CREAT | (truncate ? O_TRUNC : 0), 0644);
+		if (fd < 0) return false;
+		if (ftruncate(fd, (off_t) size) != 0) {
+			close();
+			return false;
+		}
+		void *ptr = size ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : nullptr;
+		if (ptr == MAP_FAILED) {
+			close();
+			return false;
+		}
+		head = (char *) ptr;
+		mapped_size = size;
+		return true;
+	}
+	/*
+		Maps the whole file at path read-only, e.g. to answer queries on a file written before.
+		Returns false on failure(including an empty file), leaving nothing mapped
+	*/
+	bool open_read_only(const std::string &path) {
+		close();
+		fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0) return false;
+		struct stat status;
+		void *ptr = fstat(fd, &status) == 0 && status.st_size > 0 ?
+			mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+		if (ptr == MAP_FAILED) {
+			close();
+			return false;
+		}
+		head = (char *) ptr;
+		mapped_size = status.st_size;
+		return true;
+	}
+	void close() {
+		if (head) munmap(head, mapped_size);
+		if (fd >= 0) ::close(fd);
+		fd = -1;
+		head = nullptr;
+		mapped_size = 0;
+	}
+	void swap(mapped_file &rhs) {
+		std::swap(fd, rhs.fd);
+		std::swap(head, rhs.head);
+		std::swap(mapped_size, rhs.mapped_size);
+	}
+	bool is_open() const { return head != nullptr; }
+	void *data() const { return head; }
+	size_t size() const { return mapped_size; }
+
+	// starts reading [ptr, ptr + length) into memory in the background(readahead by the OS)
+	void prefetch(const void *ptr, size_t length) const {
+		size_t offset, aligned_length;
+		if (page_range(ptr, length, offset, aligned_length)) madvise(head + offset, aligned_length, MADV_WILLNEED);
+	}
+	// starts writing [ptr, ptr + length) back to the file and lets the OS drop it from memory; the content is kept
+	void release(const void *ptr, size_t length) const {
+		size_t offset, aligned_length;
+		if (!page_range(ptr, length, offset, aligned_length)) return;
+		madvise(head + offset, aligned_length, MADV_DONTNEED);
+		posix_fadvise(fd, (off_t) offset, (off_t) aligned_length, POSIX_FADV_DONTNEED);
+	}
+private:
+	int fd = -1;
+	char *head = nullptr;
+	size_t mapped_size = 0;
+
+	// the smallest page-aligned range(offset from head) covering [ptr, ptr + length), clipped to the mapping
+	bool page_range(const void *ptr, size_t length, size_t &offset, size_t &aligned_length) const {
+		if (!head || length == 0) return false;
+		const size_t page_size = sysconf(_SC_PAGESIZE);
+		size_t begin = (const char *) ptr - head;
+		size_t end = std::min(begin + length, mapped_size);
+		offset = begin / page_size * page_size;
+		aligned_length = end - offset;
+		return true;
+	}
+};
+
+} // namespace storage
+} // namespace quick_floyd_warshall
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <algorithm>
+#include <vector>
+
+namespace quick_floyd_warshall {
+namespace negative_cycle {
+
+/*
+	matrix : src_n * src_n distance matrix computed by the Floyd-Warshall algorithm with the values saturated at -INF / 2
+		(INF means unreachable)
+	Writes -INF to matrix[i * src_n + j] for all (i, j) such that a walk from i to j can be made arbitrarily short,
+	i.e. there is a vertex v with matrix[v * src_n + v] < 0 that is reachable from i and from which j is reachable.
+	reaches_cycle[i] (if not null) is set to whether such j exists for i, i.e. whether i lies on or reaches a negative cycle.
+	Returns true if the graph contains a negative cycle
+*/
+template<typename T> bool propagate(int src_n, T *matrix, T INF, bool *reaches_cycle) {
+	std::vector<int> on_cycle;
+	for (int i = 0; i < src_n; i++) if (matrix[(size_t) i * src_n + i] < 0) on_cycle.push_back(i);
+	if (on_cycle.empty()) {
+		if (reaches_cycle) std::fill(reaches_cycle, reaches_cycle + src_n, false);
+		return false;
+	}
+
+	// reach[i] : bitset of the vertices reachable from i
+	const size_t n_words = (src_n + 63) / 64;
+	std::vector<uint64_t> reach(src_n * n_words, 0);
+	for (int i = 0; i < src_n; i++) for (int j = 0; j < src_n; j++)
+		if (matrix[(size_t) i * src_n + j] < INF) reach[i * n_words + j / 64] |= (uint64_t) 1 << (j % 64);
+	auto reachable = [&] (int i, int j) { return reach[i * n_words + j / 64] >> (j % 64) & 1; };
+
+	// the vertices on the cycles in the same strongly connected component reach the same set of vertices,
+	// so only one representative for each component is needed
+	std::vector<int> representatives;
+	for (int v : on_cycle) {
+		bool found = false;
+		for (int r : representatives) if (reachable(r, v) && reachable(v, r)) {
+			found = true;
+			break;
+		}
+		if (!found) representatives.push_back(v);
+	}
+
+	std::vector<uint64_t> unbounded(src_n * n_words, 0);
+	for (int r : representatives) for (int i = 0; i < src_n; i++) if (reachable(i, r))
+		for (size_t w = 0; w < n_words; w++) unbounded[i * n_words + w] |= reach[r * n_words + w];
+
+	for (int i = 0; i < src_n; i++) {
+		bool any = false;
+		for (size_t w = 0; w < n_words; w++) any |= unbounded[i * n_words + w] != 0;
+		if (reaches_cycle) reaches_cycle[i] = any;
+		if (!any) continue;
+		for (int j = 0; j < src_n; j++) if (unbounded[i * n_words + j / 64] >> (j % 64) & 1) matrix[(size_t) i * src_n + j] = -INF;
+	}
+	return true;
+}
+
+} // namespace negative_cycle
+} // namespace quick_floyd_warshall
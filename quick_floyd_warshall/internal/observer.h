@@ -0,0 +1,179 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+namespace quick_floyd_warshall {
+namespace observe {
+
+/*
+	The phases of a solve:
+	 - REORDER        : converting the input into the blocked layout(see blocked_matrix) and finding the all-INF blocks
+	 - SOLVE          : the recursion of FWR, including TRANSPOSE_COPY
+	 - TRANSPOSE_COPY : copying the blocks to their transposed positions in the symmetric mode(none in the triangular layout)
+	 - REORDER_BACK   : writing the result back to the row-major layout
+*/
+enum class phase_t {
+	REORDER,
+	SOLVE,
+	TRANSPOSE_COPY,
+	REORDER_BACK
+};
+constexpr int N_PHASES = 4;
+inline const char *phase_to_str(phase_t phase) {
+	if (phase == phase_t::REORDER       ) return "REORDER";
+	if (phase == phase_t::SOLVE         ) return "SOLVE";
+	if (phase == phase_t::TRANSPOSE_COPY) return "TRANSPOSE_COPY";
+	if (phase == phase_t::REORDER_BACK  ) return "REORDER_BACK";
+	return "";
+}
+
+// hardware counters of the calling thread during SOLVE(only if perf_event_open is permitted)
+struct counters_t {
+	bool available = false;
+	uint64_t cycles = 0;
+	uint64_t instructions = 0;
+	uint64_t cache_misses = 0; // the misses of the last level cache
+};
+
+struct stats_t {
+	double seconds[N_PHASES] = {}; // wall time of each phase, indexed by phase_t
+	size_t fwi_calls = 0; // FWI on three blocks executed
+	size_t fwi_skipped = 0; // FWI skipped because an operand is all INF
+	counters_t counters;
+	bool cancelled = false;
+
+	double get_seconds(phase_t phase) const { return seconds[(int) phase]; }
+};
+
+/*
+	Receives the measurements and the progress of a solve(e.g. floyd_warshall::run(src_n, input_matrix, output_matrix, symmetric, observer)).
+	Override the callbacks to use them; they do nothing by default.
+	cancel() may be called from any thread, including the callbacks, and the solve stops at the next boundary of FWR.
+	The flag stays set, so an observer is meant to be used for one solve
+*/
+class observer {
+public:
+	virtual ~observer () = default;
+	// called at the end of each phase
+	virtual void on_phase(phase_t phase, double seconds) { (void) phase; (void) seconds; }
+	/*
+		called at the boundaries of FWR with the number of the leaf steps(FWI on three blocks, executed or skipped) done and in total,
+		about 1000 times per solve at most, never concurrently(but from a worker thread in parallel_floyd_warshall)
+	*/
+	virtual void on_progress(size_t done, size_t total) { (void) done; (void) total; }
+
+	void cancel() { cancel_flag.store(true, std::memory_order_relaxed); }
+	bool cancelled() const { return cancel_flag.load(std::memory_order_relaxed); }
+
+	stats_t stats; // filled by the solve
+private:
+	std::atomic<bool> cancel_flag { false };
+};
+
+class stopwatch {
+public:
+	double seconds() const { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); }
+private:
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+};
+
+// cycles, instructions, and cache misses of the calling thread in user space, via perf_event_open
+class hardware_counters {
+public:
+	hardware_counters () {
+		const uint64_t configs[3] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES };
+		for (int i = 0; i < 3; i++) fds[i] = open_counter(configs[i]);
+	}
+	hardware_counters (const hardware_counters &) = delete;
+	hardware_counters &operator = (const hardware_counters &) = delete;
+	~hardware_counters () { for (int fd : fds) if (fd >= 0) close(fd); }
+
+	bool available() const { return fds[0] >= 0 && fds[1] >= 0 && fds[2] >= 0; }
+	void start() {
+		if (!available()) return;
+		for (int fd : fds) ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+		for (int fd : fds) ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+	}
+	counters_t stop() {
+		counters_t res;
+		if (!available()) return res;
+		uint64_t values[3] = {};
+		res.available = true;
+		for (int i = 0; i < 3; i++) {
+			ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+			res.available &= read(fds[i], &values[i], sizeof(uint64_t)) == (ssize_t) sizeof(uint64_t);
+		}
+		res.cycles = values[0];
+		res.instructions = values[1];
+		res.cache_misses = values[2];
+		return res;
+	}
+private:
+	int fds[3];
+
+	static int open_counter(uint64_t config) {
+		perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.size = sizeof(attr);
+		attr.config = config;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+	}
+};
+
+/*
+	The state of an observed solve shared by the recursion of FWR(and the threads of parallel_floyd_warshall).
+	total is the number of the leaf steps the solve will take
+*/
+class tracker {
+public:
+	tracker (observer &target, size_t total) : target(target), total(total) {}
+
+	// a leaf step: FWI on three blocks, executed or skipped
+	void step(bool executed) {
+		done.fetch_add(1, std::memory_order_relaxed);
+		if (executed) n_executed.fetch_add(1, std::memory_order_relaxed);
+	}
+	// called at a boundary of FWR: reports the progress if it advanced by 1/1000 of total since the last report, and returns false if cancelled
+	bool check() {
+		const size_t cur = done.load(std::memory_order_relaxed);
+		size_t last = last_reported.load(std::memory_order_relaxed);
+		if (cur >= last + std::max<size_t>(1, total / 1000) && last_reported.compare_exchange_strong(last, cur)) {
+			std::lock_guard<std::mutex> lock(mutex);
+			target.on_progress(cur, total);
+		}
+		return !target.cancelled();
+	}
+	void add_seconds(phase_t phase, double seconds) {
+		std::lock_guard<std::mutex> lock(mutex);
+		target.stats.seconds[(int) phase] += seconds;
+	}
+	// writes the counts of the steps to the stats and reports the final progress
+	void finish() {
+		target.stats.fwi_calls = n_executed;
+		target.stats.fwi_skipped = done - n_executed;
+		if (done != last_reported) target.on_progress(done, total);
+	}
+private:
+	observer &target;
+	const size_t total;
+	std::atomic<size_t> done { 0 };
+	std::atomic<size_t> n_executed { 0 };
+	std::atomic<size_t> last_reported { 0 };
+	std::mutex mutex;
+};
+
+} // namespace observe
+} // namespace quick_floyd_warshall
@@ -0,0 +1,81 @@
+#pragma once
+#include "observer.h"
+
+namespace quick_floyd_warshall {
+namespace recursion {
+
+/*
+	The recursive order of the steps of the blocked Floyd-Warshall algorithm(FWR) on n_blocks * n_blocks blocks,
+	independent of what a block holds, so that the solvers on other matrices(e.g. transitive_closure) walk the blocks in the same order.
+	The blocks are only referred to by their indices; a step (i, k, j) is expected to update block (i, j) with blocks (i, k), (k, j)
+*/
+
+/*
+	The symmetric step of FWR on the blocks [block_index, block_index + 2 * half) in the triangular layout,
+	where only the blocks (i, j) with i <= j are stored and (j, i) is read as (i, j) transposed(see floyd_warshall::operand()).
+	With X = [block_index, block_index + half) and Y = [block_index + half, block_index + 2 * half),
+	(X, Y) is the transpose of (Y, X), so the update of (Y, X) by (Y, Y) is done as the update of (X, Y) by (Y, Y) instead
+	and no block is copied to its transposed position.
+	The products (Y, X) * (X, Y) and (X, Y) * (Y, X) are symmetric, so only their upper blocks are computed.
+	sub_call(block_index0, block_index1, block_index2, symmetric) runs FWR on the half * half blocks from the given ones
+*/
+template<typename SubCall> void solve_triangular(int half, int block_index, const SubCall &sub_call) {
+	const int x = block_index, y = block_index + half;
+	sub_call(x, x, x, true);
+	sub_call(x, x, y, false);
+	sub_call(y, x, y, false);
+	sub_call(y, y, y, true);
+	sub_call(x, y, y, false);
+	sub_call(x, y, x, false);
+}
+
+/*
+	Runs leaf(block_index0', block_index1', block_index2') for the blocks in the recursive order.
+	If symmetric(block_index0 = block_index1 = block_index2), only half of the steps are run and
+	transpose(n, block_row_offset, block_column_offset) is expected to copy the n * n blocks from the given one to their transposed positions,
+	or in the triangular layout, the steps writing blocks below the diagonal are skipped(see solve_triangular()).
+	If tracker is not null, the progress is reported at the start of each non-leaf call, and the recursion unwinds once cancelled
+*/
+template<typename Leaf, typename Transpose> void FWR(int n_blocks_power2, int n_blocks, int block_index0, int block_index1, int block_index2,
+	bool triangular, bool symmetric, const Leaf &leaf, const Transpose &transpose, observe::tracker *tracker = nullptr) {
+	
+	if (block_index0 >= n_blocks || block_index1 >= n_blocks || block_index2 >= n_blocks) return;
+	if (triangular && block_index0 > block_index2) return;
+	if (n_blocks_power2 == 1) {
+		leaf(block_index0, block_index1, block_index2);
+	} else {
+		if (tracker && !tracker->check()) return;
+		int half = n_blocks_power2 >> 1;
+		auto sub_call = [&] (int index0, int index1, int index2, bool sub_symmetric) {
+			FWR(half, n_blocks, index0, index1, index2, triangular, sub_symmetric, leaf, transpose, tracker);
+		};
+		if (!symmetric) {
+			sub_call(block_index0       , block_index1       , block_index2       , false);
+			sub_call(block_index0       , block_index1       , block_index2 + half, false);
+			sub_call(block_index0 + half, block_index1       , block_index2       , false);
+			sub_call(block_index0 + half, block_index1       , block_index2 + half, false);
+			sub_call(block_index0 + half, block_index1 + half, block_index2 + half, false);
+			sub_call(block_index0 + half, block_index1 + half, block_index2       , false);
+			sub_call(block_index0       , block_index1 + half, block_index2 + half, false);
+			sub_call(block_index0       , block_index1 + half, block_index2       , false);
+		} else if (triangular) {
+			solve_triangular(half, block_index0, sub_call);
+		} else {
+			sub_call(block_index0       , block_index1       , block_index2       , true );
+			sub_call(block_index0       , block_index1       , block_index2 + half, false);
+			transpose(half, block_index0, block_index0 + half);
+			sub_call(block_index0 + half, block_index1       , block_index2 + half, false);
+			sub_call(block_index0 + half, block_index1 + half, block_index2 + half, true );
+			sub_call(block_index0 + half, block_index1 + half, block_index2       , false);
+			transpose(half, block_index0 + half, block_index0);
+			sub_call(block_index0       , block_index1 + half, block_index2       , false);
+		}
+	}
+}
+// FWR on all the n_blocks * n_blocks blocks without the symmetric mode
+template<typename Leaf> void FWR(int n_blocks_power2, int n_blocks, const Leaf &leaf) {
+	FWR(n_blocks_power2, n_blocks, 0, 0, 0, false, false, leaf, [] (int, int, int) {});
+}
+
+} // namespace recursion
+} // namespace quick_floyd_warshall
@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+
+namespace quick_floyd_warshall {
+namespace semiring {
+
+/*
+	The semirings(choose, extend) of the path problems, as the policies of the kernels of floyd_warshall.
+	The kernels work on the encoded values(see blocked_matrix::encode: negated, or complemented for the unsigned types),
+	where choosing the better of two paths is always max, so a semiring gives extend(lhs, rhs) on the encoded values:
+	the value of a path through the two parts.
+	The encoded value of no path is the same -INF(0 for the unsigned types) for all of them, which every extend keeps,
+	so the all-INF blocks are skipped in the same way.
+	 - min_plus : the shortest paths(min, +)
+	 - min_max  : the minimax paths(min, max), e.g. the route whose largest latency is the smallest.
+		max of the values is min of the encoded ones, and no edge is INF as in min_plus
+	 - max_min  : the widest paths(max, min), e.g. the route whose bottleneck capacity is the largest.
+		The values are stored as they are instead of encoded(raw), which is min_max on the encoded values of -x(~x for the unsigned types),
+		so no edge is -INF(0 for the unsigned types) and the larger values are better
+	extend takes vector_t(see vectorize::vector_t), or anything with + and min
+*/
+struct min_plus {
+	static constexpr bool raw = false;
+	static std::string name() { return "min_plus"; }
+	template<typename V> static V extend(const V &lhs, const V &rhs) { return lhs + rhs; }
+};
+struct min_max {
+	static constexpr bool raw = false;
+	static std::string name() { return "min_max"; }
+	template<typename V> static V extend(const V &lhs, const V &rhs) { return min(lhs, rhs); }
+};
+struct max_min {
+	static constexpr bool raw = true;
+	static std::string name() { return "max_min"; }
+	template<typename V> static V extend(const V &lhs, const V &rhs) { return min(lhs, rhs); }
+};
+
+} // namespace semiring
+} // namespace quick_floyd_warshall
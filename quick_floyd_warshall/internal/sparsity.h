@@ -0,0 +1,110 @@
+#pragma once
+#include <cstddef>
+#include <algorithm>
+#include <vector>
+
+namespace quick_floyd_warshall {
+namespace sparsity {
+
+/*
+	Flags of the blocks of an n_blocks * n_blocks block matrix known to be all INF(no pair in them is connected yet).
+	FWI on the blocks (i, j), (i, k), (k, j) cannot change (i, j) if (i, k) or (k, j) is all INF, so such calls can be skipped.
+	A block only stops being all INF, so a flag is cleared when the block is written and found to have a finite element.
+	The flags are bytes rather than bits so that the threads of parallel_floyd_warshall can update different blocks concurrently.
+	If symmetric, (i, j) and (j, i) share the flag of the one with i <= j(for the triangular layout, see block_table)
+*/
+class block_mask {
+public:
+	block_mask () = default;
+	explicit block_mask (int n_blocks, bool symmetric = false) : n_blocks(n_blocks), symmetric(symmetric), all_inf((size_t) n_blocks * n_blocks, 0) {}
+	// same as *this = block_mask(n_blocks, symmetric), but keeps the memory if it is large enough
+	void assign(int n_blocks, bool symmetric = false) {
+		this->n_blocks = n_blocks;
+		this->symmetric = symmetric;
+		all_inf.assign((size_t) n_blocks * n_blocks, 0);
+	}
+	bool is_inf(int block_row, int block_column) const { return all_inf[index(block_row, block_column)]; }
+	void set(int block_row, int block_column, bool inf) { all_inf[index(block_row, block_column)] = inf; }
+	// the number of blocks flagged all INF
+	size_t count() const { return std::count(all_inf.begin(), all_inf.end(), 1); }
+private:
+	int n_blocks = 0;
+	bool symmetric = false;
+	std::vector<char> all_inf;
+	
+	size_t index(int block_row, int block_column) const {
+		if (symmetric && block_row > block_column) std::swap(block_row, block_column);
+		return (size_t) block_row * n_blocks + block_column;
+	}
+};
+
+/*
+	The reverse Cuthill-McKee order of the vertices of the graph given as an n * n adjacency matrix(INF for no edge),
+	with the edges taken as undirected: order[i] is the vertex to be placed at index i.
+	Each connected component is visited in BFS from a vertex of the minimum degree, adding the neighbors in the increasing order of the degree,
+	so the components occupy contiguous ranges and the edges stay close to the diagonal.
+	After renumbering with it, the blocks far from the diagonal stay all INF longer in the Floyd-Warshall algorithm(see block_mask).
+	Takes O(n^2) time
+*/
+template<typename T> std::vector<int> reverse_cuthill_mckee(int n, const T *matrix, T INF) {
+	std::vector<std::vector<int> > adjacent(n);
+	for (int i = 0; i < n; i++) for (int j = i + 1; j < n; j++)
+		if (matrix[(size_t) i * n + j] < INF || matrix[(size_t) j * n + i] < INF) {
+			adjacent[i].push_back(j);
+			adjacent[j].push_back(i);
+		}
+	auto by_degree = [&] (int u, int v) { return adjacent[u].size() != adjacent[v].size() ? adjacent[u].size() < adjacent[v].size() : u < v; };
+	std::vector<int> by_min_degree(n);
+	for (int i = 0; i < n; i++) by_min_degree[i] = i;
+	std::sort(by_min_degree.begin(), by_min_degree.end(), by_degree);
+	for (auto &list : adjacent) std::sort(list.begin(), list.end(), by_degree);
+
+	std::vector<int> order;
+	order.reserve(n);
+	std::vector<bool> visited(n, false);
+	for (int start : by_min_degree) if (!visited[start]) {
+		visited[start] = true;
+		size_t head = order.size();
+		order.push_back(start);
+		for (; head < order.size(); head++)
+			for (int v : adjacent[order[head]]) if (!visited[v]) {
+				visited[v] = true;
+				order.push_back(v);
+			}
+	}
+	std::reverse(order.begin(), order.end());
+	return order;
+}
+
+/*
+	The weakly connected components of the graph given as an n * n adjacency matrix(INF for no edge):
+	the vertices of each component in the increasing order, the components ordered by their smallest vertex.
+	No path leaves a component, so each of them can be solved as an independent graph.
+	Takes O(n^2) time with a union-find over a row-major scan of the matrix
+*/
+template<typename T> std::vector<std::vector<int> > weakly_connected_components(int n, const T *matrix, T INF) {
+	std::vector<int> parent(n);
+	for (int i = 0; i < n; i++) parent[i] = i;
+	auto root = [&] (int v) {
+		while (parent[v] != v) v = parent[v] = parent[parent[v]];
+		return v;
+	};
+	for (int i = 0; i < n; i++) for (int j = 0; j < n; j++) if (i != j && matrix[(size_t) i * n + j] < INF) {
+		int u = root(i), v = root(j);
+		if (u != v) parent[std::max(u, v)] = std::min(u, v);
+	}
+	std::vector<std::vector<int> > components;
+	std::vector<int> index(n, -1);
+	for (int i = 0; i < n; i++) {
+		int r = root(i);
+		if (index[r] < 0) {
+			index[r] = components.size();
+			components.emplace_back();
+		}
+		components[index[r]].push_back(i);
+	}
+	return components;
+}
+
+} // namespace sparsity
+} // namespace quick_floyd_warshall
@@ -0,0 +1,157 @@
+#pragma once
+#include <algorithm>
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <thread>
+
+namespace quick_floyd_warshall {
+namespace parallel {
+
+/*
+	work-stealing thread pool
+	 - each thread owns a deque of tasks; deque 0 is shared by the threads calling run_all() from outside the pool
+	 - run_all() pushes tasks to the deque of the calling thread and works on them until they are all finished,
+		stealing tasks from other threads' deques when its own deque is empty,
+		and sleeps until they are finished or more tasks are queued once there is nothing left to steal
+	 - run_all() can be called from inside a task (nested parallelism) and from any thread outside the pool,
+		which works as thread 0 of the pool during the call
+*/
+class thread_pool {
+	struct task_t {
+		const std::function<void()> *func;
+		std::atomic<int> *pending;
+	};
+	struct worker_queue_t {
+		std::mutex mutex;
+		std::deque<task_t> tasks;
+	};
+
+	int n_threads;
+	std::vector<worker_queue_t> queues;
+	std::vector<std::thread> workers;
+	std::atomic<int> n_queued;
+	std::atomic<bool> stop;
+	std::mutex sleep_mutex;
+	std::condition_variable sleep_cv;
+
+	struct thread_state_t {
+		thread_pool *pool;
+		int index;
+	};
+	static thread_state_t &thread_state() {
+		static thread_local thread_state_t state = { nullptr, -1 };
+		return state;
+	}
+
+	bool pop(int index, task_t &task) {
+		worker_queue_t &queue = queues[index];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.tasks.empty()) return false;
+		task = queue.tasks.back();
+		queue.tasks.pop_back();
+		n_queued--;
+		return true;
+	}
+	bool steal(int index, task_t &task) {
+		for (int i = 1; i < n_threads; i++) {
+			worker_queue_t &queue = queues[(index + i) % n_threads];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (queue.tasks.empty()) continue;
+			task = queue.tasks.front();
+			queue.tasks.pop_front();
+			n_queued--;
+			return true;
+		}
+		return false;
+	}
+	bool try_run_one(int index) {
+		task_t task;
+		if (!pop(index, task) && !steal(index, task)) return false;
+		(*task.func)();
+		if (task.pending->fetch_sub(1, std::memory_order_release) == 1) {
+			// the caller of run_all() may be sleeping; it no longer touches pending once it has seen 0
+			std::lock_guard<std::mutex> lock(sleep_mutex);
+			sleep_cv.notify_all();
+		}
+		return true;
+	}
+	// registers the calling thread as thread 0 of the pool if it is not in the pool, and restores its previous state on destruction
+	class caller_guard {
+	public:
+		explicit caller_guard(thread_pool *pool) : state(thread_state()), saved(state) {
+			if (state.pool != pool) state = { pool, 0 };
+		}
+		~caller_guard() { state = saved; }
+		int index() const { return state.index; }
+	private:
+		thread_state_t &state;
+		thread_state_t saved;
+	};
+	void worker_main(int index) {
+		thread_state() = { this, index };
+		while (true) {
+			if (try_run_one(index)) continue;
+			std::unique_lock<std::mutex> lock(sleep_mutex);
+			sleep_cv.wait(lock, [this] { return stop || n_queued > 0; });
+			if (stop) return;
+		}
+	}
+public:
+	// n_threads <= 0 : use all the hardware threads
+	explicit thread_pool(int n_threads = 0) : n_threads(n_threads > 0 ? n_threads : (int) std::thread::hardware_concurrency()),
+		queues(std::max(this->n_threads, 1)), n_queued(0), stop(false) {
+
+		if (this->n_threads <= 0) this->n_threads = 1;
+		for (int i = 1; i < this->n_threads; i++) workers.emplace_back(&thread_pool::worker_main, this, i);
+	}
+	~thread_pool() {
+		{
+			std::lock_guard<std::mutex> lock(sleep_mutex);
+			stop = true;
+		}
+		sleep_cv.notify_all();
+		for (auto &worker : workers) worker.join();
+	}
+	thread_pool(const thread_pool &) = delete;
+	thread_pool &operator = (const thread_pool &) = delete;
+
+	int size() const { return n_threads; }
+
+	// execute funcs[0], ..., funcs[n - 1] in parallel and return after all of them are finished
+	void run_all(const std::function<void()> *funcs, int n) {
+		if (n <= 0) return;
+		if (n == 1 || n_threads == 1) {
+			for (int i = 0; i < n; i++) funcs[i]();
+			return;
+		}
+		caller_guard caller(this);
+		const int index = caller.index();
+
+		std::atomic<int> pending(n - 1);
+		{
+			worker_queue_t &queue = queues[index];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			for (int i = n - 1; i >= 1; i--) queue.tasks.push_back({ funcs + i, &pending });
+			n_queued += n - 1;
+		}
+		{
+			std::lock_guard<std::mutex> lock(sleep_mutex);
+		}
+		sleep_cv.notify_all();
+
+		funcs[0]();
+		while (pending.load(std::memory_order_acquire) > 0) {
+			if (try_run_one(index)) continue;
+			// the rest are running on the other threads
+			std::unique_lock<std::mutex> lock(sleep_mutex);
+			sleep_cv.wait(lock, [this, &pending] { return pending.load(std::memory_order_acquire) == 0 || n_queued > 0; });
+		}
+	}
+};
+
+} // namespace parallel
+} // namespace quick_floyd_warshall
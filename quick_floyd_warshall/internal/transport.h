@@ -0,0 +1,146 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <unistd.h>
+#include <sys/socket.h>
+
+namespace quick_floyd_warshall {
+namespace distributed {
+
+/*
+	The point-to-point messages between the ranks 0, 1, ..., size() - 1 of a distributed solve(see distributed_floyd_warshall).
+	Messages between two ranks arrive in the order they are sent and are received with the same size.
+	send() may block until the receiver takes the message, so the ranks must agree on the order of the transfers.
+	Each rank has its own transport object, which is used by one thread at a time.
+	Returns false on a failure of the underlying channel
+*/
+class transport {
+public:
+	virtual ~transport () = default;
+	virtual int rank() const = 0;
+	virtual int size() const = 0;
+	virtual bool send(int destination, const void *data, size_t length) = 0;
+	virtual bool recv(int source, void *data, size_t length) = 0;
+};
+
+/*
+	The ranks as threads of one process, exchanging the messages through the queues of a shared hub.
+	send() never blocks. For tests and for running the distributed algorithm on one machine
+*/
+class loopback_hub {
+public:
+	explicit loopback_hub (int n_ranks) : n_ranks(n_ranks), channels((size_t) n_ranks * n_ranks) {}
+	// the transport of rank; valid while the hub is alive
+	std::unique_ptr<transport> connect(int rank) { return std::unique_ptr<transport>(new endpoint(*this, rank)); }
+private:
+	struct channel_t {
+		std::mutex mutex;
+		std::condition_variable cond;
+		std::deque<std::vector<char> > messages;
+	};
+	class endpoint : public transport {
+	public:
+		endpoint (loopback_hub &hub, int rank) : hub(hub), my_rank(rank) {}
+		int rank() const override { return my_rank; }
+		int size() const override { return hub.n_ranks; }
+		bool send(int destination, const void *data, size_t length) override {
+			channel_t &channel = hub.channel(my_rank, destination);
+			{
+				std::lock_guard<std::mutex> lock(channel.mutex);
+				channel.messages.emplace_back((const char *) data, (const char *) data + length);
+			}
+			channel.cond.notify_one();
+			return true;
+		}
+		bool recv(int source, void *data, size_t length) override {
+			channel_t &channel = hub.channel(source, my_rank);
+			std::unique_lock<std::mutex> lock(channel.mutex);
+			channel.cond.wait(lock, [&channel] { return !channel.messages.empty(); });
+			std::vector<char> message = std::move(channel.messages.front());
+			channel.messages.pop_front();
+			if (message.size() != length) return false;
+			memcpy(data, message.data(), length);
+			return true;
+		}
+	private:
+		loopback_hub &hub;
+		int my_rank;
+	};
+	int n_ranks;
+	std::vector<channel_t> channels;
+
+	channel_t &channel(int source, int destination) { return channels[(size_t) source * n_ranks + destination]; }
+};
+
+/*
+	The ranks connected by stream sockets: socket_fds[peer] is a connected socket to rank peer(ignored for rank itself).
+	Works across processes and nodes with any way of connecting the sockets(e.g. TCP set up by a launcher),
+	and with connect_local() for the processes forked on one machine.
+	The sockets are closed by the destructor
+*/
+class socket_transport : public transport {
+public:
+	socket_transport (int rank, std::vector<int> socket_fds) : my_rank(rank), fds(std::move(socket_fds)) {}
+	socket_transport (const socket_transport &) = delete;
+	socket_transport &operator = (const socket_transport &) = delete;
+	~socket_transport () { for (int i = 0; i < (int) fds.size(); i++) if (i != my_rank && fds[i] >= 0) close(fds[i]); }
+
+	int rank() const override { return my_rank; }
+	int size() const override { return fds.size(); }
+	bool send(int destination, const void *data, size_t length) override {
+		for (const char *ptr = (const char *) data; length; ) {
+			ssize_t written = ::send(fds[destination], ptr, length, MSG_NOSIGNAL);
+			if (written <= 0) return false;
+			ptr += written;
+			length -= written;
+		}
+		return true;
+	}
+	bool recv(int source, void *data, size_t length) override {
+		for (char *ptr = (char *) data; length; ) {
+			ssize_t read_size = ::recv(fds[source], ptr, length, 0);
+			if (read_size <= 0) return false;
+			ptr += read_size;
+			length -= read_size;
+		}
+		return true;
+	}
+	/*
+		Connected Unix domain socket pairs between every two of n_ranks ranks on this machine:
+		res[rank] is the socket_fds of rank for the constructor. Create them before forking the processes of the ranks,
+		and in each process, close the sockets of the other ranks(see close_others()).
+		Returns an empty vector on failure
+	*/
+	static std::vector<std::vector<int> > connect_local(int n_ranks) {
+		std::vector<std::vector<int> > res(n_ranks, std::vector<int>(n_ranks, -1));
+		for (int i = 0; i < n_ranks; i++) for (int j = i + 1; j < n_ranks; j++) {
+			int pair[2];
+			if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+				close_others(res, -1);
+				return {};
+			}
+			res[i][j] = pair[0];
+			res[j][i] = pair[1];
+		}
+		return res;
+	}
+	// closes the sockets in fds of connect_local() except those of rank
+	static void close_others(std::vector<std::vector<int> > &fds, int rank) {
+		for (int i = 0; i < (int) fds.size(); i++) if (i != rank) for (int &fd : fds[i]) {
+			if (fd >= 0) close(fd);
+			fd = -1;
+		}
+	}
+private:
+	int my_rank;
+	std::vector<int> fds;
+};
+
+} // namespace distributed
+} // namespace quick_floyd_warshall
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include "vectorize.h"
+
+namespace quick_floyd_warshall {
+namespace tuning {
+
+// the parameters of floyd_warshall that don't affect the result but the performance
+struct config_t {
+	int block_size;
+	int unroll_type;
+};
+
+/*
+	A tuning profile is a text file with one line for each (inst_set, T):
+		<inst_set> <T> <block_size> <unroll_type>
+	e.g.
+		AVX2 int64_t 64 3
+		AVX2 int32_t 128 1
+*/
+
+// $QFW_TUNING_PROFILE if set, otherwise $HOME/.quick_floyd_warshall_profile
+inline std::string default_profile_path() {
+	const char *path = std::getenv("QFW_TUNING_PROFILE");
+	if (path && *path) return path;
+	const char *home = std::getenv("HOME");
+	return std::string(home ? home : ".") + "/.quick_floyd_warshall_profile";
+}
+
+// returns false if the file or the line for (inst_set, type_name) doesn't exist
+inline bool load(const std::string &path, vectorize::InstSet inst_set, const std::string &type_name, config_t &config) {
+	std::ifstream file(path);
+	std::string line;
+	while (std::getline(file, line)) {
+		std::istringstream stream(line);
+		std::string cur_inst_set, cur_type_name;
+		config_t cur_config;
+		if (!(stream >> cur_inst_set >> cur_type_name >> cur_config.block_size >> cur_config.unroll_type)) continue;
+		if (cur_inst_set == vectorize::inst_set_to_str(inst_set) && cur_type_name == type_name) {
+			config = cur_config;
+			return true;
+		}
+	}
+	return false;
+}
+// replaces the line for (inst_set, type_name) with config, keeping the other lines; returns false on I/O failure
+inline bool save(const std::string &path, vectorize::InstSet inst_set, const std::string &type_name, const config_t &config) {
+	const std::string key = vectorize::inst_set_to_str(inst_set) + " " + type_name + " ";
+	std::vector<std::string> lines;
+	{
+		std::ifstream file(path);
+		std::string line;
+		while (std::getline(file, line)) if (line.compare(0, key.size(), key) != 0) lines.push_back(line);
+	}
+	lines.push_back(key + std::to_string(config.block_size) + " " + std::to_string(config.unroll_type));
+
+	std::ofstream file(path, std::ios::trunc);
+	for (auto &line : lines) file << line << "\n";
+	return (bool) file;
+}
+
+} // namespace tuning
+} // namespace quick_floyd_warshall
@@ -4,6 +4,7 @@
 #include <string>
 #include <algorithm>
 #include <immintrin.h>
+#include <cpuid.h>
 
 namespace quick_floyd_warshall {
 namespace vectorize {
@@ -22,9 +23,74 @@ std::string inst_set_to_str(InstSet inst_set) {
 	if (inst_set == InstSet::AVX512 ) return "AVX512";
 	return "";
 }
+template<typename T> std::string type_to_str() {
+	if (std::is_floating_point<T>::value) return sizeof(T) == sizeof(float) ? "float" : "double";
+	return (std::is_signed<T>::value ? "int" : "uint") + std::to_string(sizeof(T) * 8) + "_t";
+}
+
+/*
+	Every vector_t for SIMD instruction sets is compiled with the corresponding target options(#pragma GCC target)
+	so that they can be used without passing -m options to the compiler.
+	target_region<inst_set>::call(f) calls f() in a function compiled for inst_set, into which
+	everything called by f is inlined(flatten). Code using vector_t<inst_set, *> has to be called through it,
+	otherwise the member functions of vector_t cannot be inlined.
+	(friend functions defined in a class and inherited constructors do not get the target options of #pragma GCC target,
+	so the friend functions have the target attribute explicitly and the constructor from internal_vector_t is
+	redefined in each vector_t instead of inherited)
+*/
+template<InstSet inst_set> struct target_region;
+template<> struct target_region<InstSet::DEFAULT> {
+	template<typename F> __attribute__((flatten)) static void call(F f) { f(); }
+};
+template<> struct target_region<InstSet::SSE4_2> {
+	template<typename F> __attribute__((target("sse4.2"), flatten)) static void call(F f) { f(); }
+};
+template<> struct target_region<InstSet::AVX2> {
+	template<typename F> __attribute__((target("avx2"), flatten)) static void call(F f) { f(); }
+};
+template<> struct target_region<InstSet::AVX512> {
+	template<typename F> __attribute__((target("avx512f,avx512bw"), flatten)) static void call(F f) { f(); }
+};
+
+/*
+	unroll<N>::run(f) calls f(0), f(1), ..., f(N - 1) unrolled at compile time;
+	in a target_region everything is inlined, so the arguments are constants and arrays of vectors indexed by them stay in the registers
+*/
+template<int N> struct unroll {
+	template<typename F> static void run(const F &f) { unroll<N - 1>::run(f); f(N - 1); }
+};
+template<> struct unroll<0> {
+	template<typename F> static void run(const F &) {}
+};
+
+// whether the running CPU(and OS) supports inst_set; checked with cpuid and xgetbv
+inline bool is_supported(InstSet inst_set) {
+	if (inst_set == InstSet::DEFAULT) return true;
+	unsigned int eax, ebx, ecx, edx;
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+	if (inst_set == InstSet::SSE4_2) return ecx & bit_SSE4_2;
+	
+	// AVX2 and AVX512 need the OS to save the ymm/zmm registers on context switches
+	if (!(ecx & bit_OSXSAVE)) return false;
+	unsigned int xcr0_low, xcr0_high;
+	__asm__ ("xgetbv" : "=a" (xcr0_low), "=d" (xcr0_high) : "c" (0));
+	if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+	if (inst_set == InstSet::AVX2) return (xcr0_low & 0x06) == 0x06 && (ebx & bit_AVX2);
+	if (inst_set == InstSet::AVX512) return (xcr0_low & 0xe6) == 0xe6 && (ebx & bit_AVX512F) && (ebx & bit_AVX512BW);
+	return false;
+}
+// the most powerful instruction set supported by the running CPU
+inline InstSet best_inst_set() {
+	if (is_supported(InstSet::AVX512)) return InstSet::AVX512;
+	if (is_supported(InstSet::AVX2)) return InstSet::AVX2;
+	if (is_supported(InstSet::SSE4_2)) return InstSet::SSE4_2;
+	return InstSet::DEFAULT;
+}
 
 // wrapper of sse/avx intrinsics
 template<InstSet inst_set> class vector_base_t;
+#pragma GCC push_options
+#pragma GCC target("sse4.2")
 template<> class vector_base_t<InstSet::SSE4_2> {
 public:
 	static constexpr int SIZE = 16;
@@ -36,7 +102,10 @@ public:
 	vector_base_t (void *ptr) : vec(_mm_load_si128((internal_vector_t *) ptr)) {}
 	vector_base_t &store(void *ptr) { _mm_store_si128((internal_vector_t *) ptr, vec); return *this; }
 };
+#pragma GCC pop_options
 template<InstSet inst_set> class vector_base_t;
+#pragma GCC push_options
+#pragma GCC target("avx2")
 template<> class vector_base_t<InstSet::AVX2> {
 public:
 	static constexpr int SIZE = 32;
@@ -48,6 +117,9 @@ public:
 	vector_base_t (void *ptr) : vec(_mm256_load_si256((internal_vector_t *) ptr)) {}
 	vector_base_t &store(void *ptr) { _mm256_store_si256((internal_vector_t *) ptr, vec); return *this; }
 };
+#pragma GCC pop_options
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512bw")
 template<> class vector_base_t<InstSet::AVX512> {
 public:
 	static constexpr int SIZE = 64;
@@ -59,121 +131,254 @@ public:
 	vector_base_t (void *ptr) : vec(_mm512_load_si512((internal_vector_t *) ptr)) {}
 	vector_base_t &store(void *ptr) { _mm512_store_si512((internal_vector_t *) ptr, vec); return *this; }
 };
+#pragma GCC pop_options
 
 template<InstSet inst_set, typename T> class vector_t;
 
 /*
 	vec.chmin_store(mem): mem[i] = min(mem[i], vec[i])
 	vec.chmax_store(mem): mem[i] = max(mem[i], vec[i])
+	greater(lhs, rhs): mask of lanes with lhs[i] > rhs[i]
+	vector_t::blend(mask, if_true, if_false): if_true[i] for the lanes in mask, if_false[i] for the others;
+		mask_t is the same for vector_t of types with the same size, so a mask can be used to blend vectors of another type
+		(vector_base_t for SSE4_2 and AVX2, so that it is not returned as a raw vector type)
+	vector_t::mask_to_bits(mask): bit i is set iff lane i is in mask
+	
+	For the unsigned types(uint8_t, uint16_t), the lanes hold complemented distances(~d = MAX - d, 0 meaning unreachable)
+	and + is the saturating addition of the distances they represent: a + b = max(0, a + b - MAX), i.e. ~min(MAX, ~a + ~b).
+	It is computed as subs(a, ~b), so that ~b is hoisted out of the loops when b is a broadcast coefficient.
+	min, max, greater are the unsigned comparisons and unary/binary - are not provided
 */
 
 
 // DEFAULT / *
 template<typename T> class vector_t<InstSet::DEFAULT, T> {
-	static_assert(std::is_same<T, int16_t>::value || std::is_same<T, int32_t>::value || std::is_same<T, int64_t>::value, "");
+	static_assert(std::is_same<T, int16_t>::value || std::is_same<T, int32_t>::value || std::is_same<T, int64_t>::value ||
+		std::is_same<T, float>::value || std::is_same<T, double>::value ||
+		std::is_same<T, uint8_t>::value || std::is_same<T, uint16_t>::value, "");
 public:
 	static constexpr int SIZE = sizeof(T);
 	T val;
 	vector_t &store(void *ptr) { *((T *) ptr) = val; return *this; }
+	vector_t () = default;
 	vector_t (void *val) : val(*((T *)val)) {}
 	vector_t (T val) : val(val) {}
-	vector_t operator + (const vector_t &rhs) const { return { T(val + rhs.val) }; }
+	vector_t operator + (const vector_t &rhs) const { return { add(val, rhs.val, std::is_unsigned<T>()) }; }
 	vector_t operator - (const vector_t &rhs) const { return { T(val - rhs.val) }; }
 	vector_t operator - () const { return { -val }; }
 	friend vector_t min(const vector_t &lhs, const vector_t &rhs) { return { std::min(lhs.val, rhs.val) }; }
 	friend vector_t max(const vector_t &lhs, const vector_t &rhs) { return { std::max(lhs.val, rhs.val) }; }
 	vector_t &chmin_store(void *ptr) { if (*((T *) ptr) > val) store(ptr); return *this; }
 	vector_t &chmax_store(void *ptr) { if (*((T *) ptr) < val) store(ptr); return *this; }
+	using mask_t = bool;
+	friend mask_t greater(const vector_t &lhs, const vector_t &rhs) { return lhs.val > rhs.val; }
+	static vector_t blend(mask_t mask, const vector_t &if_true, const vector_t &if_false) { return mask ? if_true : if_false; }
+	static uint64_t mask_to_bits(mask_t mask) { return mask; }
+private:
+	static T add(T lhs, T rhs, std::false_type) { return T(lhs + rhs); }
+	static T add(T lhs, T rhs, std::true_type) { return lhs > T(~rhs) ? T(lhs - T(~rhs)) : T(0); } // saturating, see above
 };
 
 
 
+#pragma GCC push_options
+#pragma GCC target("sse4.2")
 // SSE4.2 / int16_t
 template<> class vector_t<InstSet::SSE4_2, int16_t> : public vector_base_t<InstSet::SSE4_2> {
 public:
 	using vector_base_t<InstSet::SSE4_2>::vector_base_t;
+	vector_t (internal_vector_t vec_) : vector_base_t(vec_) {}
 	vector_t (int16_t val) : vector_base_t(_mm_set1_epi16(val)) {}
 	vector_t operator + (const vector_t &rhs) const { return { _mm_add_epi16(vec, rhs.vec) }; }
 	vector_t operator - (const vector_t &rhs) const { return { _mm_sub_epi16(vec, rhs.vec) }; }
 	vector_t operator - () const { return { _mm_sub_epi16(_mm_setzero_si128(), vec) }; }
-	friend vector_t min(const vector_t &lhs, const vector_t &rhs) { return { _mm_min_epi16(lhs.vec, rhs.vec) }; }
-	friend vector_t max(const vector_t &lhs, const vector_t &rhs) { return { _mm_max_epi16(lhs.vec, rhs.vec) }; }
+	friend __attribute__((target("sse4.2"))) vector_t min(const vector_t &lhs, const vector_t &rhs) { return { _mm_min_epi16(lhs.vec, rhs.vec) }; }
+	friend __attribute__((target("sse4.2"))) vector_t max(const vector_t &lhs, const vector_t &rhs) { return { _mm_max_epi16(lhs.vec, rhs.vec) }; }
 	vector_t &chmin_store(void *ptr) { min(*this, vector_t(ptr)).store(ptr); return *this; }
 	vector_t &chmax_store(void *ptr) { max(*this, vector_t(ptr)).store(ptr); return *this; }
+	using mask_t = vector_base_t<InstSet::SSE4_2>;
+	friend __attribute__((target("sse4.2"))) mask_t greater(const vector_t &lhs, const vector_t &rhs) { return { _mm_cmpgt_epi16(lhs.vec, rhs.vec) }; }
+	static vector_t blend(const mask_t &mask, const vector_t &if_true, const vector_t &if_false) { return { _mm_blendv_epi8(if_false.vec, if_true.vec, mask.vec) }; }
+	static uint64_t mask_to_bits(const mask_t &mask) { return _mm_movemask_epi8(_mm_packs_epi16(mask.vec, _mm_setzero_si128())); }
 };
 // SSE4.2 / int32_t
 template<> class vector_t<InstSet::SSE4_2, int32_t> : public vector_base_t<InstSet::SSE4_2> {
 public:
 	using vector_base_t<InstSet::SSE4_2>::vector_base_t;
+	vector_t (internal_vector_t vec_) : vector_base_t(vec_) {}
 	vector_t (int32_t val) : vector_base_t(_mm_set1_epi32(val)) {}
 	vector_t operator + (const vector_t &rhs) const { return { _mm_add_epi32(vec, rhs.vec) }; }
 	vector_t operator - (const vector_t &rhs) const { return { _mm_sub_epi32(vec, rhs.vec) }; }
 	vector_t operator - () const { return { _mm_sub_epi32(_mm_setzero_si128(), vec) }; }
-	friend vector_t min(const vector_t &lhs, const vector_t &rhs) { return { _mm_min_epi32(lhs.vec, rhs.vec) }; }
-	friend vector_t max(const vector_t &lhs, const vector_t &rhs) { return { _mm_max_epi32(lhs.vec, rhs.vec) }; }
+	friend __attribute__((target("sse4.2"))) vector_t min(const vector_t &lhs, const vector_t &rhs) { return { _mm_min_epi32(lhs.vec, rhs.vec) }; }
+	friend __attribute__((target("sse4.2"))) vector_t max(const vector_t &lhs, const vector_t &rhs) { return { _mm_max_epi32(lhs.vec, rhs.vec) }; }
 	vector_t &chmin_store(void *ptr) { min(*this, vector_t(ptr)).store(ptr); return *this; }
 	vector_t &chmax_store(void *ptr) { max(*this, vector_t(ptr)).store(ptr); return *this; }
+	using mask_t = vector_base_t<InstSet::SSE4_2>;
+	friend __attribute__((target("sse4.2"))) mask_t greater(const vector_t &lhs, const vector_t &rhs) { return { _mm_cmpgt_epi32(lhs.vec, rhs.vec) }; }
+	static vector_t blend(const mask_t &mask, const vector_t &if_true, const vector_t &if_false) { return { _mm_blendv_epi8(if_false.vec, if_true.vec, mask.vec) }; }
+	static uint64_t mask_to_bits(const mask_t &mask) { return _mm_movemask_ps(_mm_castsi128_ps(mask.vec)); }
 };
 // SSE4.2 / int64_t
 template<> class vector_t<InstSet::SSE4_2, int64_t> : public vector_base_t<InstSet::SSE4_2> {
 public:
 	using vector_base_t<InstSet::SSE4_2>::vector_base_t;
+	vector_t (internal_vector_t vec_) : vector_base_t(vec_) {}
 	vector_t (int64_t val) : vector_base_t(_mm_set1_epi64((__m64) val)) {}
 	vector_t operator + (const vector_t &rhs) const { return { _mm_add_epi64(vec, rhs.vec) }; }
 	vector_t operator - (const vector_t &rhs) const { return { _mm_sub_epi64(vec, rhs.vec) }; }
 	vector_t operator - () const { return { _mm_sub_epi64(_mm_setzero_si128(), vec) }; }
 	// SSE4 doesn't have _mm_min_epi64 / _mm_max_epi64
-	friend vector_t min(const vector_t &lhs, const vector_t &rhs) { return {
+	friend __attribute__((target("sse4.2"))) vector_t min(const vector_t &lhs, const vector_t &rhs) { return {
 		_mm_blendv_epi8(lhs.vec, rhs.vec, _mm_cmpgt_epi64(lhs.vec, rhs.vec))
 	}; }
-	friend vector_t max(const vector_t &lhs, const vector_t &rhs) { return {
+	friend __attribute__((target("sse4.2"))) vector_t max(const vector_t &lhs, const vector_t &rhs) { return {
 		_mm_blendv_epi8(lhs.vec, rhs.vec, _mm_cmpgt_epi64(rhs.vec, lhs.vec))
 	}; }
 	vector_t &chmin_store(void *ptr) { min(*this, vector_t(ptr)).store(ptr); return *this; }
 	vector_t &chmax_store(void *ptr) { max(*this, vector_t(ptr)).store(ptr); return *this; }
+	using mask_t = vector_base_t<InstSet::SSE4_2>;
+	friend __attribute__((target("sse4.2"))) mask_t greater(const vector_t &lhs, const vector_t &rhs) { return { _mm_cmpgt_epi64(lhs.vec, rhs.vec) }; }
+	static vector_t blend(const mask_t &mask, const vector_t &if_true, const vector_t &if_false) { return { _mm_blendv_epi8(if_false.vec, if_true.vec, mask.vec) }; }
+	static uint64_t mask_to_bits(const mask_t &mask) { return _mm_movemask_pd(_mm_castsi128_pd(mask.vec)); }
+};
+// SSE4.2 / uint8_t
+template<> class vector_t<InstSet::SSE4_2, uint8_t> : public vector_base_t<InstSet::SSE4_2> {
+public:
+	using vector_base_t<InstSet::SSE4_2>::vector_base_t;
+	vector_t (internal_vector_t vec_) : vector_base_t(vec_) {}
+	vector_t (uint8_t val) : vector_base_t(_mm_set1_epi8((char) val)) {}
+	vector_t operator + (const vector_t &rhs) const { return { _mm_subs_epu8(vec, _mm_xor_si128(rhs.vec, _mm_set1_epi8(-1))) }; }
+	friend __attribute__((target("sse4.2"))) vector_t min(const vector_t &lhs, const vector_t &rhs) { return { _mm_min_epu8(lhs.vec, rhs.vec) }; }
+	friend __attribute__((target("sse4.2"))) vector_t max(const vector_t &lhs, const vector_t &rhs) { return { _mm_max_epu8(lhs.vec, rhs.vec) }; }
+	vector_t &chmin_store(void *ptr) { min(*this, vector_t(ptr)).store(ptr); return *this; }
+	vector_t &chmax_store(void *ptr) { max(*this, vector_t(ptr)).store(ptr); return *this; }
+	using mask_t = vector_base_t<InstSet::SSE4_2>;
+	// there is no unsigned comparison before AVX-512: lhs > rhs iff max(lhs, rhs) != rhs
+	friend __attribute__((target("sse4.2"))) mask_t greater(const vector_t &lhs, const vector_t &rhs) {
+		return { _mm_xor_si128(_mm_cmpeq_epi8(_mm_max_epu8(lhs.vec, rhs.vec), rhs.vec), _mm_set1_epi8(-1)) };
+	}
+	static vector_t blend(const mask_t &mask, const vector_t &if_true, const vector_t &if_false) { return { _mm_blendv_epi8(if_false.vec, if_true.vec, mask.vec) }; }
+	static uint64_t mask_to_bits(const mask_t &mask) { return (unsigned int) _mm_movemask_epi8(mask.vec); }
+};
+// SSE4.2 / uint16_t
+template<> class vector_t<InstSet::SSE4_2, uint16_t> : public vector_base_t<InstSet::SSE4_2> {
+public:
+	using vector_base_t<InstSet::SSE4_2>::vector_base_t;
+	vector_t (internal_vector_t vec_) : vector_base_t(vec_) {}
+	vector_t (uint16_t val) : vector_base_t(_mm_set1_epi16((short) val)) {}
+	vector_t operator + (const vector_t &rhs) const { return { _mm_subs_epu16(vec, _mm_xor_si128(rhs.vec, _mm_set1_epi8(-1))) }; }
+	friend __attribute__((target("sse4.2"))) vector_t min(const vector_t &lhs, const vector_t &rhs) { return { _mm_min_epu16(lhs.vec, rhs.vec) }; }
+	friend __attribute__((target("sse4.2"))) vector_t max(const vector_t &lhs, const vector_t &rhs) { return { _mm_max_epu16(lhs.vec, rhs.vec) }; }
+	vector_t &chmin_store(void *ptr) { min(*this, vector_t(ptr)).store(ptr); return *this; }
+	vector_t &chmax_store(void *ptr) { max(*this, vector_t(ptr)).store(ptr); return *this; }
+	using mask_t = vector_base_t<InstSet::SSE4_2>;
+	// there is no unsigned comparison before AVX-512: lhs > rhs iff max(lhs, rhs) != rhs
+	friend __attribute__((target("sse4.2"))) mask_t greater(const vector_t &lhs, const vector_t &rhs) {
+		return { _mm_xor_si128(_mm_cmpeq_epi16(_mm_max_epu16(lhs.vec, rhs.vec), rhs.vec), _mm_set1_epi8(-1)) };
+	}
+	static vector_t blend(const mask_t &mask, const vector_t &if_true, const vector_t &if_false) { return { _mm_blendv_epi8(if_false.vec, if_true.vec, mask.vec) }; }
+	static uint64_t mask_to_bits(const mask_t &mask) { return _mm_movemask_epi8(_mm_packs_epi16(mask.vec, _mm_setzero_si128())); }
+};
+// SSE4.2 / float
+template<> class vector_t<InstSet::SSE4_2, float> : public vector_base_t<InstSet::SSE4_2> {
+public:
+	using vector_base_t<InstSet::SSE4_2>::vector_base_t;
+	vector_t (internal_vector_t vec_) : vector_base_t(vec_) {}
+	vector_t (__m128 vec_) : vector_base_t(_mm_castps_si128(vec_)) {}
+	vector_t (float val) : vector_base_t(_mm_castps_si128(_mm_set1_ps(val))) {}
+	__m128 fvec() const { return _mm_castsi128_ps(vec); }
+	vector_t operator + (const vector_t &rhs) const { return { _mm_add_ps(fvec(), rhs.fvec()) }; }
+	vector_t operator - (const vector_t &rhs) const { return { _mm_sub_ps(fvec(), rhs.fvec()) }; }
+	vector_t operator - () const { return { _mm_sub_ps(_mm_setzero_ps(), fvec()) }; }
+	friend __attribute__((target("sse4.2"))) vector_t min(const vector_t &lhs, const vector_t &rhs) { return { _mm_min_ps(lhs.fvec(), rhs.fvec()) }; }
+	friend __attribute__((target("sse4.2"))) vector_t max(const vector_t &lhs, const vector_t &rhs) { return { _mm_max_ps(lhs.fvec(), rhs.fvec()) }; }
+	vector_t &chmin_store(void *ptr) { min(*this, vector_t(ptr)).store(ptr); return *this; }
+	vector_t &chmax_store(void *ptr) { max(*this, vector_t(ptr)).store(ptr); return *this; }
+	using mask_t = vector_base_t<InstSet::SSE4_2>;
+	friend __attribute__((target("sse4.2"))) mask_t greater(const vector_t &lhs, const vector_t &rhs) { return { _mm_castps_si128(_mm_cmpgt_ps(lhs.fvec(), rhs.fvec())) }; }
+	static vector_t blend(const mask_t &mask, const vector_t &if_true, const vector_t &if_false) { return { _mm_blendv_epi8(if_false.vec, if_true.vec, mask.vec) }; }
+	static uint64_t mask_to_bits(const mask_t &mask) { return _mm_movemask_ps(_mm_castsi128_ps(mask.vec)); }
+};
+// SSE4.2 / double
+template<> class vector_t<InstSet::SSE4_2, double> : public vector_base_t<InstSet::SSE4_2> {
+public:
+	using vector_base_t<InstSet::SSE4_2>::vector_base_t;
+	vector_t (internal_vector_t vec_) : vector_base_t(vec_) {}
+	vector_t (__m128d vec_) : vector_base_t(_mm_castpd_si128(vec_)) {}
+	vector_t (double val) : vector_base_t(_mm_castpd_si128(_mm_set1_pd(val))) {}
+	__m128d fvec() const { return _mm_castsi128_pd(vec); }
+	vector_t operator + (const vector_t &rhs) const { return { _mm_add_pd(fvec(), rhs.fvec()) }; }
+	vector_t operator - (const vector_t &rhs) const { return { _mm_sub_pd(fvec(), rhs.fvec()) }; }
+	vector_t operator - () const { return { _mm_sub_pd(_mm_setzero_pd(), fvec()) }; }
+	friend __attribute__((target("sse4.2"))) vector_t min(const vector_t &lhs, const vector_t &rhs) { return { _mm_min_pd(lhs.fvec(), rhs.fvec()) }; }
+	friend __attribute__((target("sse4.2"))) vector_t max(const vector_t &lhs, const vector_t &rhs) { return { _mm_max_pd(lhs.fvec(), rhs.fvec()) }; }
+	vector_t &chmin_store(void *ptr) { min(*this, vector_t(ptr)).store(ptr); return *this; }
+	vector_t &chmax_store(void *ptr) { max(*this, vector_t(ptr)).store(ptr); return *this; }
+	using mask_t = vector_base_t<InstSet::SSE4_2>;
+	friend __attribute__((target("sse4.2"))) mask_t greater(const vector_t &lhs, const vector_t &rhs) { return { _mm_castpd_si128(_mm_cmpgt_pd(lhs.fvec(), rhs.fvec())) }; }
+	static vector_t blend(const mask_t &mask, const vector_t &if_true, const vector_t &if_false) { return { _mm_blendv_epi8(if_false.vec, if_true.vec, mask.vec) }; }
+	static uint64_t mask_to_bits(const mask_t &mask) { return _mm_movemask_pd(_mm_castsi128_pd(mask.vec)); }
 };
+#pragma GCC pop_options
 
 
 
+#pragma GCC push_options
+#pragma GCC target("avx2")
 // AVX2 / int16_t
 template<> class vector_t<InstSet::AVX2, int16_t> : public vector_base_t<InstSet::AVX2> {
 public:
 	using vector_base_t<InstSet::AVX2>::vector_base_t;
+	vector_t (internal_vector_t vec_) : vector_base_t(vec_) {}
 	vector_t (int16_t val) : vector_base_t(_mm256_set1_epi16(val)) {}
 	vector_t operator + (const vector_t &rhs) const { return { _mm256_add_epi16(vec, rhs.vec) }; }
 	vector_t operator - (const vector_t &rhs) const { return { _mm256_sub_epi16(vec, rhs.vec) }; }
 	vector_t operator - () const { return { _mm256_sub_epi16(_mm256_setzero_si256(), vec) }; }
-	friend vector_t min(const vector_t &lhs, const vector_t &rhs) { return { _mm256_min_epi16(lhs.vec, rhs.vec) }; }
-	friend vector_t max(const vector_t &lhs, const vector_t &rhs) { return { _mm256_max_epi16(lhs.vec, rhs.vec) }; }
+	friend __attribute__((target("avx2"))) vector_t min(const vector_t &lhs, const vector_t &rhs) { return { _mm256_min_epi16(lhs.vec, rhs.vec) }; }
+	friend __attribute__((target("avx2"))) vector_t max(const vector_t &lhs, const vector_t &rhs) { return { _mm256_max_epi16(lhs.vec, rhs.vec) }; }
 	vector_t &chmin_store(void *ptr) { min(*this, vector_t(ptr)).store(ptr); return *this; }
 	vector_t &chmax_store(void *ptr) { max(*this, vector_t(ptr)).store(ptr); return *this; }
+	using mask_t = vector_base_t<InstSet::AVX2>;
+	friend __attribute__((target("avx2"))) mask_t greater(const vector_t &lhs, const vector_t &rhs) { return { _mm256_cmpgt_epi16(lhs.vec, rhs.vec) }; }
+	static vector_t blend(const mask_t &mask, const vector_t &if_true, const vector_t &if_false) { return { _mm256_blendv_epi8(if_false.vec, if_true.vec, mask.vec) }; }
+	static uint64_t mask_to_bits(const mask_t &mask) { // packs_epi16 works in each 128-bit lane
+		unsigned int bits = _mm256_movemask_epi8(_mm256_packs_epi16(mask.vec, _mm256_setzero_si256()));
+		return (bits & 0xFF) | ((bits >> 8) & 0xFF00);
+	}
 };
 // AVX2 / int32_t
 template<> class vector_t<InstSet::AVX2, int32_t> : public vector_base_t<InstSet::AVX2> {
 public:
 	using vector_base_t<InstSet::AVX2>::vector_base_t;
+	vector_t (internal_vector_t vec_) : vector_base_t(vec_) {}
 	vector_t (int32_t val) : vector_base_t(_mm256_set1_epi32(val)) {}
 	vector_t operator + (const vector_t &rhs) const { return { _mm256_add_epi32(vec, rhs.vec) }; }
 	vector_t operator - (const vector_t &rhs) const { return { _mm256_sub_epi32(vec, rhs.vec) }; }
 	vector_t operator - () const { return { _mm256_sub_epi32(_mm256_setzero_si256(), vec) }; }
-	friend vector_t min(const vector_t &lhs, const vector_t &rhs) { return { _mm256_min_epi32(lhs.vec, rhs.vec) }; }
-	friend vector_t max(const vector_t &lhs, const vector_t &rhs) { return { _mm256_max_epi32(lhs.vec, rhs.vec) }; }
+	friend __attribute__((target("avx2"))) vector_t min(const vector_t &lhs, const vector_t &rhs) { return { _mm256_min_epi32(lhs.vec, rhs.vec) }; }
+	friend __attribute__((target("avx2"))) vector_t max(const vector_t &lhs, const vector_t &rhs) { return { _mm256_max_epi32(lhs.vec, rhs.vec) }; }
 	vector_t &chmin_store(void *ptr) { min(*this, vector_t(ptr)).store(ptr); return *this; }
 	vector_t &chmax_store(void *ptr) { max(*this, vector_t(ptr)).store(ptr); return *this; }
+	using mask_t = vector_base_t<InstSet::AVX2>;
+	friend __attribute__((target("avx2"))) mask_t greater(const vector_t &lhs, const vector_t &rhs) { return { _mm256_cmpgt_epi32(lhs.vec, rhs.vec) }; }
+	static vector_t blend(const mask_t &mask, const vector_t &if_true, const vector_t &if_false) { return { _mm256_blendv_epi8(if_false.vec, if_true.vec, mask.vec) }; }
+	static uint64_t mask_to_bits(const mask_t &mask) { return _mm256_movemask_ps(_mm256_castsi256_ps(mask.vec)); }
 };
 // AVX2 / int64_t
 template<> class vector_t<InstSet::AVX2, int64_t> : public vector_base_t<InstSet::AVX2> {
 public:
 	using vector_base_t<InstSet::AVX2>::vector_base_t;
+	vector_t (internal_vector_t vec_) : vector_base_t(vec_) {}
 	vector_t (int64_t val) : vector_base_t(_mm256_set1_epi64x(val)) {}
 	vector_t operator + (const vector_t &rhs) const { return { _mm256_add_epi64(vec, rhs.vec) }; }
 	vector_t operator - (const vector_t &rhs) const { return { _mm256_sub_epi64(vec, rhs.vec) }; }
 	vector_t operator - () const { return { _mm256_sub_epi64(_mm256_setzero_si256(), vec) }; }
 	// avx2 doesn't have _mm256_min_epi64 / _mm256_max_epi64
-	friend vector_t min(const vector_t &lhs, const vector_t &rhs) { return {
+	friend __attribute__((target("avx2"))) vector_t min(const vector_t &lhs, const vector_t &rhs) { return {
 		_mm256_blendv_epi8(lhs.vec, rhs.vec, _mm256_cmpgt_epi64(lhs.vec, rhs.vec))
 	}; }
-	friend vector_t max(const vector_t &lhs, const vector_t &rhs) { return {
+	friend __attribute__((target("avx2"))) vector_t max(const vector_t &lhs, const vector_t &rhs) { return {
 		_mm256_blendv_epi8(lhs.vec, rhs.vec, _mm256_cmpgt_epi64(rhs.vec, lhs.vec))
 	}; }
 	vector_t &chmin_store(void *ptr) { // slower because of separate load instruction in the 1st operand of cmpgt
@@ -184,20 +389,109 @@ public:
 		_mm256_maskstore_epi64((long long *) ptr, _mm256_cmpgt_epi64(vec, vector_t(ptr).vec), vec);
 		return *this;
 	}
+	using mask_t = vector_base_t<InstSet::AVX2>;
+	friend __attribute__((target("avx2"))) mask_t greater(const vector_t &lhs, const vector_t &rhs) { return { _mm256_cmpgt_epi64(lhs.vec, rhs.vec) }; }
+	static vector_t blend(const mask_t &mask, const vector_t &if_true, const vector_t &if_false) { return { _mm256_blendv_epi8(if_false.vec, if_true.vec, mask.vec) }; }
+	static uint64_t mask_to_bits(const mask_t &mask) { return _mm256_movemask_pd(_mm256_castsi256_pd(mask.vec)); }
+};
+// AVX2 / uint8_t
+template<> class vector_t<InstSet::AVX2, uint8_t> : public vector_base_t<InstSet::AVX2> {
+public:
+	using vector_base_t<InstSet::AVX2>::vector_base_t;
+	vector_t (internal_vector_t vec_) : vector_base_t(vec_) {}
+	vector_t (uint8_t val) : vector_base_t(_mm256_set1_epi8((char) val)) {}
+	vector_t operator + (const vector_t &rhs) const { return { _mm256_subs_epu8(vec, _mm256_xor_si256(rhs.vec, _mm256_set1_epi8(-1))) }; }
+	friend __attribute__((target("avx2"))) vector_t min(const vector_t &lhs, const vector_t &rhs) { return { _mm256_min_epu8(lhs.vec, rhs.vec) }; }
+	friend __attribute__((target("avx2"))) vector_t max(const vector_t &lhs, const vector_t &rhs) { return { _mm256_max_epu8(lhs.vec, rhs.vec) }; }
+	vector_t &chmin_store(void *ptr) { min(*this, vector_t(ptr)).store(ptr); return *this; }
+	vector_t &chmax_store(void *ptr) { max(*this, vector_t(ptr)).store(ptr); return *this; }
+	using mask_t = vector_base_t<InstSet::AVX2>;
+	// there is no unsigned comparison before AVX-512: lhs > rhs iff max(lhs, rhs) != rhs
+	friend __attribute__((target("avx2"))) mask_t greater(const vector_t &lhs, const vector_t &rhs) {
+		return { _mm256_xor_si256(_mm256_cmpeq_epi8(_mm256_max_epu8(lhs.vec, rhs.vec), rhs.vec), _mm256_set1_epi8(-1)) };
+	}
+	static vector_t blend(const mask_t &mask, const vector_t &if_true, const vector_t &if_false) { return { _mm256_blendv_epi8(if_false.vec, if_true.vec, mask.vec) }; }
+	static uint64_t mask_to_bits(const mask_t &mask) { return (unsigned int) _mm256_movemask_epi8(mask.vec); }
 };
+// AVX2 / uint16_t
+template<> class vector_t<InstSet::AVX2, uint16_t> : public vector_base_t<InstSet::AVX2> {
+public:
+	using vector_base_t<InstSet::AVX2>::vector_base_t;
+	vector_t (internal_vector_t vec_) : vector_base_t(vec_) {}
+	vector_t (uint16_t val) : vector_base_t(_mm256_set1_epi16((short) val)) {}
+	vector_t operator + (const vector_t &rhs) const { return { _mm256_subs_epu16(vec, _mm256_xor_si256(rhs.vec, _mm256_set1_epi8(-1))) }; }
+	friend __attribute__((target("avx2"))) vector_t min(const vector_t &lhs, const vector_t &rhs) { return { _mm256_min_epu16(lhs.vec, rhs.vec) }; }
+	friend __attribute__((target("avx2"))) vector_t max(const vector_t &lhs, const vector_t &rhs) { return { _mm256_max_epu16(lhs.vec, rhs.vec) }; }
+	vector_t &chmin_store(void *ptr) { min(*this, vector_t(ptr)).store(ptr); return *this; }
+	vector_t &chmax_store(void *ptr) { max(*this, vector_t(ptr)).store(ptr); return *this; }
+	using mask_t = vector_base_t<InstSet::AVX2>;
+	// there is no unsigned comparison before AVX-512: lhs > rhs iff max(lhs, rhs) != rhs
+	friend __attribute__((target("avx2"))) mask_t greater(const vector_t &lhs, const vector_t &rhs) {
+		return { _mm256_xor_si256(_mm256_cmpeq_epi16(_mm256_max_epu16(lhs.vec, rhs.vec), rhs.vec), _mm256_set1_epi8(-1)) };
+	}
+	static vector_t blend(const mask_t &mask, const vector_t &if_true, const vector_t &if_false) { return { _mm256_blendv_epi8(if_false.vec, if_true.vec, mask.vec) }; }
+	static uint64_t mask_to_bits(const mask_t &mask) { // packs_epi16 works in each 128-bit lane
+		unsigned int bits = _mm256_movemask_epi8(_mm256_packs_epi16(mask.vec, _mm256_setzero_si256()));
+		return (bits & 0xFF) | ((bits >> 8) & 0xFF00);
+	}
+};
+// AVX2 / float
+template<> class vector_t<InstSet::AVX2, float> : public vector_base_t<InstSet::AVX2> {
+public:
+	using vector_base_t<InstSet::AVX2>::vector_base_t;
+	vector_t (internal_vector_t vec_) : vector_base_t(vec_) {}
+	vector_t (__m256 vec_) : vector_base_t(_mm256_castps_si256(vec_)) {}
+	vector_t (float val) : vector_base_t(_mm256_castps_si256(_mm256_set1_ps(val))) {}
+	__m256 fvec() const { return _mm256_castsi256_ps(vec); }
+	vector_t operator + (const vector_t &rhs) const { return { _mm256_add_ps(fvec(), rhs.fvec()) }; }
+	vector_t operator - (const vector_t &rhs) const { return { _mm256_sub_ps(fvec(), rhs.fvec()) }; }
+	vector_t operator - () const { return { _mm256_sub_ps(_mm256_setzero_ps(), fvec()) }; }
+	friend __attribute__((target("avx2"))) vector_t min(const vector_t &lhs, const vector_t &rhs) { return { _mm256_min_ps(lhs.fvec(), rhs.fvec()) }; }
+	friend __attribute__((target("avx2"))) vector_t max(const vector_t &lhs, const vector_t &rhs) { return { _mm256_max_ps(lhs.fvec(), rhs.fvec()) }; }
+	vector_t &chmin_store(void *ptr) { min(*this, vector_t(ptr)).store(ptr); return *this; }
+	vector_t &chmax_store(void *ptr) { max(*this, vector_t(ptr)).store(ptr); return *this; }
+	using mask_t = vector_base_t<InstSet::AVX2>;
+	friend __attribute__((target("avx2"))) mask_t greater(const vector_t &lhs, const vector_t &rhs) { return { _mm256_castps_si256(_mm256_cmp_ps(lhs.fvec(), rhs.fvec(), _CMP_GT_OQ)) }; }
+	static vector_t blend(const mask_t &mask, const vector_t &if_true, const vector_t &if_false) { return { _mm256_blendv_epi8(if_false.vec, if_true.vec, mask.vec) }; }
+	static uint64_t mask_to_bits(const mask_t &mask) { return _mm256_movemask_ps(_mm256_castsi256_ps(mask.vec)); }
+};
+// AVX2 / double
+template<> class vector_t<InstSet::AVX2, double> : public vector_base_t<InstSet::AVX2> {
+public:
+	using vector_base_t<InstSet::AVX2>::vector_base_t;
+	vector_t (internal_vector_t vec_) : vector_base_t(vec_) {}
+	vector_t (__m256d vec_) : vector_base_t(_mm256_castpd_si256(vec_)) {}
+	vector_t (double val) : vector_base_t(_mm256_castpd_si256(_mm256_set1_pd(val))) {}
+	__m256d fvec() const { return _mm256_castsi256_pd(vec); }
+	vector_t operator + (const vector_t &rhs) const { return { _mm256_add_pd(fvec(), rhs.fvec()) }; }
+	vector_t operator - (const vector_t &rhs) const { return { _mm256_sub_pd(fvec(), rhs.fvec()) }; }
+	vector_t operator - () const { return { _mm256_sub_pd(_mm256_setzero_pd(), fvec()) }; }
+	friend __attribute__((target("avx2"))) vector_t min(const vector_t &lhs, const vector_t &rhs) { return { _mm256_min_pd(lhs.fvec(), rhs.fvec()) }; }
+	friend __attribute__((target("avx2"))) vector_t max(const vector_t &lhs, const vector_t &rhs) { return { _mm256_max_pd(lhs.fvec(), rhs.fvec()) }; }
+	vector_t &chmin_store(void *ptr) { min(*this, vector_t(ptr)).store(ptr); return *this; }
+	vector_t &chmax_store(void *ptr) { max(*this, vector_t(ptr)).store(ptr); return *this; }
+	using mask_t = vector_base_t<InstSet::AVX2>;
+	friend __attribute__((target("avx2"))) mask_t greater(const vector_t &lhs, const vector_t &rhs) { return { _mm256_castpd_si256(_mm256_cmp_pd(lhs.fvec(), rhs.fvec(), _CMP_GT_OQ)) }; }
+	static vector_t blend(const mask_t &mask, const vector_t &if_true, const vector_t &if_false) { return { _mm256_blendv_epi8(if_false.vec, if_true.vec, mask.vec) }; }
+	static uint64_t mask_to_bits(const mask_t &mask) { return _mm256_movemask_pd(_mm256_castsi256_pd(mask.vec)); }
+};
+#pragma GCC pop_options
 
 
 
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512bw")
 // AVX512 / int16_t
 template<> class vector_t<InstSet::AVX512, int16_t> : public vector_base_t<InstSet::AVX512> {
 public:
 	using vector_base_t<InstSet::AVX512>::vector_base_t;
+	vector_t (internal_vector_t vec_) : vector_base_t(vec_) {}
 	vector_t (int16_t val) : vector_base_t(_mm512_set1_epi16(val)) {}
 	vector_t operator + (const vector_t &rhs) const { return { _mm512_add_epi16(vec, rhs.vec) }; }
 	vector_t operator - (const vector_t &rhs) const { return { _mm512_sub_epi16(vec, rhs.vec) }; }
 	vector_t operator - () const { return { _mm512_sub_epi16(_mm512_setzero_si512(), vec) }; }
-	friend vector_t min(const vector_t &lhs, const vector_t &rhs) { return { _mm512_min_epi16(lhs.vec, rhs.vec) }; }
-	friend vector_t max(const vector_t &lhs, const vector_t &rhs) { return { _mm512_max_epi16(lhs.vec, rhs.vec) }; }
+	friend __attribute__((target("avx512f,avx512bw"))) vector_t min(const vector_t &lhs, const vector_t &rhs) { return { _mm512_min_epi16(lhs.vec, rhs.vec) }; }
+	friend __attribute__((target("avx512f,avx512bw"))) vector_t max(const vector_t &lhs, const vector_t &rhs) { return { _mm512_max_epi16(lhs.vec, rhs.vec) }; }
 	vector_t &chmin_store(void *ptr) {
 		_mm512_mask_storeu_epi16((internal_vector_t *) (ptr),
 			_mm512_cmp_epi16_mask(vec, _mm512_load_si512((internal_vector_t *) ptr), _MM_CMPINT_LT), vec);
@@ -208,17 +502,25 @@ public:
 			_mm512_cmp_epi16_mask(vec, _mm512_load_si512((internal_vector_t *) ptr), _MM_CMPINT_GT), vec);
 		return *this;
 	}
+	using mask_t = __mmask32;
+	friend __attribute__((target("avx512f,avx512bw"))) mask_t greater(const vector_t &lhs, const vector_t &rhs) {
+		return _mm512_cmp_epi16_mask(lhs.vec, rhs.vec, _MM_CMPINT_GT);
+	}
+	static vector_t blend(mask_t mask, const vector_t &if_true, const vector_t &if_false) { return { _mm512_mask_blend_epi16(mask, if_false.vec, if_true.vec) }; }
+	static uint64_t mask_to_bits(mask_t mask) { return mask; }
 };
 // AVX512 / int32_t
 template<> class vector_t<InstSet::AVX512, int32_t> : public vector_base_t<InstSet::AVX512> {
 public:
 	using vector_base_t<InstSet::AVX512>::vector_base_t;
+	vector_t (internal_vector_t vec_) : vector_base_t(vec_) {}
 	vector_t (int32_t val) : vector_base_t(_mm512_set1_epi32(val)) {}
 	vector_t operator + (const vector_t &rhs) const { return { _mm512_add_epi32(vec, rhs.vec) }; }
 	vector_t operator - (const vector_t &rhs) const { return { _mm512_sub_epi32(vec, rhs.vec) }; }
 	vector_t operator - () const { return { _mm512_sub_epi32(_mm512_setzero_si512(), vec) }; }
-	friend vector_t min(const vector_t &lhs, const vector_t &rhs) { return { _mm512_min_epi32(lhs.vec, rhs.vec) }; }
-	friend vector_t max(const vector_t &lhs, const vector_t &rhs) { return { _mm512_max_epi32(lhs.vec, rhs.vec) }; }
+	// the unmasked version causes a false -Wmaybe-uninitialized warning with some versions of GCC
+	friend __attribute__((target("avx512f,avx512bw"))) vector_t min(const vector_t &lhs, const vector_t &rhs) { return { _mm512_maskz_min_epi32(0xFFFF, lhs.vec, rhs.vec) }; }
+	friend __attribute__((target("avx512f,avx512bw"))) vector_t max(const vector_t &lhs, const vector_t &rhs) { return { _mm512_maskz_max_epi32(0xFFFF, lhs.vec, rhs.vec) }; }
 	vector_t &chmin_store(void *ptr) {
 		_mm512_mask_store_epi32((internal_vector_t *) (ptr),
 			_mm512_cmp_epi32_mask(vec, _mm512_load_si512((internal_vector_t *) ptr), _MM_CMPINT_LT), vec);
@@ -229,17 +531,25 @@ public:
 			_mm512_cmp_epi32_mask(vec, _mm512_load_si512((internal_vector_t *) ptr), _MM_CMPINT_GT), vec);
 		return *this;
 	}
+	using mask_t = __mmask16;
+	friend __attribute__((target("avx512f,avx512bw"))) mask_t greater(const vector_t &lhs, const vector_t &rhs) {
+		return _mm512_cmp_epi32_mask(lhs.vec, rhs.vec, _MM_CMPINT_GT);
+	}
+	static vector_t blend(mask_t mask, const vector_t &if_true, const vector_t &if_false) { return { _mm512_mask_blend_epi32(mask, if_false.vec, if_true.vec) }; }
+	static uint64_t mask_to_bits(mask_t mask) { return mask; }
 };
 // AVX512 / int64_t
 template<> class vector_t<InstSet::AVX512, int64_t> : public vector_base_t<InstSet::AVX512> {
 public:
 	using vector_base_t<InstSet::AVX512>::vector_base_t;
+	vector_t (internal_vector_t vec_) : vector_base_t(vec_) {}
 	vector_t (int64_t val) : vector_base_t(_mm512_set1_epi64(val)) {}
 	vector_t operator + (const vector_t &rhs) const { return { _mm512_add_epi64(vec, rhs.vec) }; }
 	vector_t operator - (const vector_t &rhs) const { return { _mm512_sub_epi64(vec, rhs.vec) }; }
 	vector_t operator - () const { return { _mm512_sub_epi64(_mm512_setzero_si512(), vec) }; }
-	friend vector_t min(const vector_t &lhs, const vector_t &rhs) { return { _mm512_min_epi64(lhs.vec, rhs.vec) }; }
-	friend vector_t max(const vector_t &lhs, const vector_t &rhs) { return { _mm512_max_epi64(lhs.vec, rhs.vec) }; }
+	// the unmasked version causes a false -Wmaybe-uninitialized warning with some versions of GCC
+	friend __attribute__((target("avx512f,avx512bw"))) vector_t min(const vector_t &lhs, const vector_t &rhs) { return { _mm512_maskz_min_epi64(0xFF, lhs.vec, rhs.vec) }; }
+	friend __attribute__((target("avx512f,avx512bw"))) vector_t max(const vector_t &lhs, const vector_t &rhs) { return { _mm512_maskz_max_epi64(0xFF, lhs.vec, rhs.vec) }; }
 	vector_t &chmin_store(void *ptr) {
 		_mm512_mask_store_epi64((internal_vector_t *) (ptr),
 			_mm512_cmp_epi64_mask(vec, _mm512_load_si512((internal_vector_t *) ptr), _MM_CMPINT_LT), vec);
@@ -250,8 +560,171 @@ public:
 			_mm512_cmp_epi64_mask(vec, _mm512_load_si512((internal_vector_t *) ptr), _MM_CMPINT_GT), vec);
 		return *this;
 	}
+	using mask_t = __mmask8;
+	friend __attribute__((target("avx512f,avx512bw"))) mask_t greater(const vector_t &lhs, const vector_t &rhs) {
+		return _mm512_cmp_epi64_mask(lhs.vec, rhs.vec, _MM_CMPINT_GT);
+	}
+	static vector_t blend(mask_t mask, const vector_t &if_true, const vector_t &if_false) { return { _mm512_mask_blend_epi64(mask, if_false.vec, if_true.vec) }; }
+	static uint64_t mask_to_bits(mask_t mask) { return mask; }
+};
+// AVX512 / uint8_t
+template<> class vector_t<InstSet::AVX512, uint8_t> : public vector_base_t<InstSet::AVX512> {
+public:
+	using vector_base_t<InstSet::AVX512>::vector_base_t;
+	vector_t (internal_vector_t vec_) : vector_base_t(vec_) {}
+	vector_t (uint8_t val) : vector_base_t(_mm512_set1_epi8((char) val)) {}
+	vector_t operator + (const vector_t &rhs) const { return { _mm512_subs_epu8(vec, _mm512_xor_si512(rhs.vec, _mm512_set1_epi8(-1))) }; }
+	friend __attribute__((target("avx512f,avx512bw"))) vector_t min(const vector_t &lhs, const vector_t &rhs) { return { _mm512_min_epu8(lhs.vec, rhs.vec) }; }
+	friend __attribute__((target("avx512f,avx512bw"))) vector_t max(const vector_t &lhs, const vector_t &rhs) { return { _mm512_max_epu8(lhs.vec, rhs.vec) }; }
+	vector_t &chmin_store(void *ptr) {
+		_mm512_mask_storeu_epi8((internal_vector_t *) (ptr),
+			_mm512_cmp_epu8_mask(vec, _mm512_load_si512((internal_vector_t *) ptr), _MM_CMPINT_LT), vec);
+		return *this;
+	}
+	vector_t &chmax_store(void *ptr) {
+		_mm512_mask_storeu_epi8((internal_vector_t *) (ptr),
+			_mm512_cmp_epu8_mask(vec, _mm512_load_si512((internal_vector_t *) ptr), _MM_CMPINT_GT), vec);
+		return *this;
+	}
+	using mask_t = __mmask64;
+	friend __attribute__((target("avx512f,avx512bw"))) mask_t greater(const vector_t &lhs, const vector_t &rhs) {
+		return _mm512_cmp_epu8_mask(lhs.vec, rhs.vec, _MM_CMPINT_GT);
+	}
+	static vector_t blend(mask_t mask, const vector_t &if_true, const vector_t &if_false) { return { _mm512_mask_blend_epi8(mask, if_false.vec, if_true.vec) }; }
+	static uint64_t mask_to_bits(mask_t mask) { return mask; }
 };
+// AVX512 / uint16_t
+template<> class vector_t<InstSet::AVX512, uint16_t> : public vector_base_t<InstSet::AVX512> {
+public:
+	using vector_base_t<InstSet::AVX512>::vector_base_t;
+	vector_t (internal_vector_t vec_) : vector_base_t(vec_) {}
+	vector_t (uint16_t val) : vector_base_t(_mm512_set1_epi16((short) val)) {}
+	vector_t operator + (const vector_t &rhs) const { return { _mm512_subs_epu16(vec, _mm512_xor_si512(rhs.vec, _mm512_set1_epi8(-1))) }; }
+	friend __attribute__((target("avx512f,avx512bw"))) vector_t min(const vector_t &lhs, const vector_t &rhs) { return { _mm512_min_epu16(lhs.vec, rhs.vec) }; }
+	friend __attribute__((target("avx512f,avx512bw"))) vector_t max(const vector_t &lhs, const vector_t &rhs) { return { _mm512_max_epu16(lhs.vec, rhs.vec) }; }
+	vector_t &chmin_store(void *ptr) {
+		_mm512_mask_storeu_epi16((internal_vector_t *) (ptr),
+			_mm512_cmp_epu16_mask(vec, _mm512_load_si512((internal_vector_t *) ptr), _MM_CMPINT_LT), vec);
+		return *this;
+	}
+	vector_t &chmax_store(void *ptr) {
+		_mm512_mask_storeu_epi16((internal_vector_t *) (ptr),
+			_mm512_cmp_epu16_mask(vec, _mm512_load_si512((internal_vector_t *) ptr), _MM_CMPINT_GT), vec);
+		return *this;
+	}
+	using mask_t = __mmask32;
+	friend __attribute__((target("avx512f,avx512bw"))) mask_t greater(const vector_t &lhs, const vector_t &rhs) {
+		return _mm512_cmp_epu16_mask(lhs.vec, rhs.vec, _MM_CMPINT_GT);
+	}
+	static vector_t blend(mask_t mask, const vector_t &if_true, const vector_t &if_false) { return { _mm512_mask_blend_epi16(mask, if_false.vec, if_true.vec) }; }
+	static uint64_t mask_to_bits(mask_t mask) { return mask; }
+};
+// AVX512 / float
+template<> class vector_t<InstSet::AVX512, float> : public vector_base_t<InstSet::AVX512> {
+public:
+	using vector_base_t<InstSet::AVX512>::vector_base_t;
+	vector_t (internal_vector_t vec_) : vector_base_t(vec_) {}
+	vector_t (__m512 vec_) : vector_base_t(_mm512_castps_si512(vec_)) {}
+	vector_t (float val) : vector_base_t(_mm512_castps_si512(_mm512_set1_ps(val))) {}
+	__m512 fvec() const { return _mm512_castsi512_ps(vec); }
+	vector_t operator + (const vector_t &rhs) const { return { _mm512_add_ps(fvec(), rhs.fvec()) }; }
+	vector_t operator - (const vector_t &rhs) const { return { _mm512_sub_ps(fvec(), rhs.fvec()) }; }
+	vector_t operator - () const { return { _mm512_sub_ps(_mm512_setzero_ps(), fvec()) }; }
+	// the unmasked version causes a false -Wmaybe-uninitialized warning with some versions of GCC
+	friend __attribute__((target("avx512f,avx512bw"))) vector_t min(const vector_t &lhs, const vector_t &rhs) { return { _mm512_maskz_min_ps(0xFFFF, lhs.fvec(), rhs.fvec()) }; }
+	friend __attribute__((target("avx512f,avx512bw"))) vector_t max(const vector_t &lhs, const vector_t &rhs) { return { _mm512_maskz_max_ps(0xFFFF, lhs.fvec(), rhs.fvec()) }; }
+	vector_t &chmin_store(void *ptr) {
+		_mm512_mask_store_ps(ptr, _mm512_cmp_ps_mask(fvec(), _mm512_load_ps(ptr), _CMP_LT_OQ), fvec());
+		return *this;
+	}
+	vector_t &chmax_store(void *ptr) {
+		_mm512_mask_store_ps(ptr, _mm512_cmp_ps_mask(fvec(), _mm512_load_ps(ptr), _CMP_GT_OQ), fvec());
+		return *this;
+	}
+	using mask_t = __mmask16;
+	friend __attribute__((target("avx512f,avx512bw"))) mask_t greater(const vector_t &lhs, const vector_t &rhs) {
+		return _mm512_cmp_ps_mask(lhs.fvec(), rhs.fvec(), _CMP_GT_OQ);
+	}
+	static vector_t blend(mask_t mask, const vector_t &if_true, const vector_t &if_false) { return { _mm512_mask_blend_ps(mask, if_false.fvec(), if_true.fvec()) }; }
+	static uint64_t mask_to_bits(mask_t mask) { return mask; }
+};
+// AVX512 / double
+template<> class vector_t<InstSet::AVX512, double> : public vector_base_t<InstSet::AVX512> {
+public:
+	using vector_base_t<InstSet::AVX512>::vector_base_t;
+	vector_t (internal_vector_t vec_) : vector_base_t(vec_) {}
+	vector_t (__m512d vec_) : vector_base_t(_mm512_castpd_si512(vec_)) {}
+	vector_t (double val) : vector_base_t(_mm512_castpd_si512(_mm512_set1_pd(val))) {}
+	__m512d fvec() const { return _mm512_castsi512_pd(vec); }
+	vector_t operator + (const vector_t &rhs) const { return { _mm512_add_pd(fvec(), rhs.fvec()) }; }
+	vector_t operator - (const vector_t &rhs) const { return { _mm512_sub_pd(fvec(), rhs.fvec()) }; }
+	vector_t operator - () const { return { _mm512_sub_pd(_mm512_setzero_pd(), fvec()) }; }
+	// the unmasked version causes a false -Wmaybe-uninitialized warning with some versions of GCC
+	friend __attribute__((target("avx512f,avx512bw"))) vector_t min(const vector_t &lhs, const vector_t &rhs) { return { _mm512_maskz_min_pd(0xFF, lhs.fvec(), rhs.fvec()) }; }
+	friend __attribute__((target("avx512f,avx512bw"))) vector_t max(const vector_t &lhs, const vector_t &rhs) { return { _mm512_maskz_max_pd(0xFF, lhs.fvec(), rhs.fvec()) }; }
+	vector_t &chmin_store(void *ptr) {
+		_mm512_mask_store_pd(ptr, _mm512_cmp_pd_mask(fvec(), _mm512_load_pd(ptr), _CMP_LT_OQ), fvec());
+		return *this;
+	}
+	vector_t &chmax_store(void *ptr) {
+		_mm512_mask_store_pd(ptr, _mm512_cmp_pd_mask(fvec(), _mm512_load_pd(ptr), _CMP_GT_OQ), fvec());
+		return *this;
+	}
+	using mask_t = __mmask8;
+	friend __attribute__((target("avx512f,avx512bw"))) mask_t greater(const vector_t &lhs, const vector_t &rhs) {
+		return _mm512_cmp_pd_mask(lhs.fvec(), rhs.fvec(), _CMP_GT_OQ);
+	}
+	static vector_t blend(mask_t mask, const vector_t &if_true, const vector_t &if_false) { return { _mm512_mask_blend_pd(mask, if_false.fvec(), if_true.fvec()) }; }
+	static uint64_t mask_to_bits(mask_t mask) { return mask; }
+};
+#pragma GCC pop_options
+
 
+/*
+	bit_vector_t<inst_set> : SIZE bytes of bits for the boolean kernels(see transitive_closure)
+	lhs | rhs : bitwise or
+*/
+template<InstSet inst_set> class bit_vector_t;
+template<> class bit_vector_t<InstSet::DEFAULT> {
+public:
+	static constexpr int SIZE = sizeof(uint64_t);
+	uint64_t val;
+	bit_vector_t () = default;
+	bit_vector_t (uint64_t val) : val(val) {}
+	bit_vector_t (void *ptr) : val(*((uint64_t *) ptr)) {}
+	bit_vector_t &store(void *ptr) { *((uint64_t *) ptr) = val; return *this; }
+	bit_vector_t operator | (const bit_vector_t &rhs) const { return { val | rhs.val }; }
+};
+#pragma GCC push_options
+#pragma GCC target("sse4.2")
+template<> class bit_vector_t<InstSet::SSE4_2> : public vector_base_t<InstSet::SSE4_2> {
+public:
+	using vector_base_t<InstSet::SSE4_2>::vector_base_t;
+	bit_vector_t () = default;
+	bit_vector_t (internal_vector_t vec_) : vector_base_t(vec_) {}
+	bit_vector_t operator | (const bit_vector_t &rhs) const { return { _mm_or_si128(vec, rhs.vec) }; }
+};
+#pragma GCC pop_options
+#pragma GCC push_options
+#pragma GCC target("avx2")
+template<> class bit_vector_t<InstSet::AVX2> : public vector_base_t<InstSet::AVX2> {
+public:
+	using vector_base_t<InstSet::AVX2>::vector_base_t;
+	bit_vector_t () = default;
+	bit_vector_t (internal_vector_t vec_) : vector_base_t(vec_) {}
+	bit_vector_t operator | (const bit_vector_t &rhs) const { return { _mm256_or_si256(vec, rhs.vec) }; }
+};
+#pragma GCC pop_options
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512bw")
+template<> class bit_vector_t<InstSet::AVX512> : public vector_base_t<InstSet::AVX512> {
+public:
+	using vector_base_t<InstSet::AVX512>::vector_base_t;
+	bit_vector_t () = default;
+	bit_vector_t (internal_vector_t vec_) : vector_base_t(vec_) {}
+	bit_vector_t operator | (const bit_vector_t &rhs) const { return { _mm512_or_si512(vec, rhs.vec) }; }
+};
+#pragma GCC pop_options
 
 template<InstSet inst_set, typename T> vector_t<inst_set, T> &operator += (
 	vector_t<inst_set, T> &lhs, const vector_t<inst_set, T> &rhs) {
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <unistd.h>
+#include <sys/mman.h>
+
+namespace quick_floyd_warshall {
+namespace storage {
+
+/*
+	A grow-only anonymous memory buffer kept across solves, so that the repeated solves of similar sizes allocate nothing.
+	It is backed by huge pages where possible, which cuts the TLB misses of the blocks scattered over the whole buffer:
+	explicit ones(MAP_HUGETLB) if the system has them reserved, otherwise transparent ones requested with madvise(MADV_HUGEPAGE)
+	on a range aligned to HUGE_PAGE_SIZE.
+	The buffer is pre-faulted when it grows, so the page faults are not paid in the first solve using it either.
+	The content is not preserved when it grows
+*/
+class workspace {
+public:
+	static constexpr size_t HUGE_PAGE_SIZE = 2 << 20;
+
+	workspace () = default;
+	workspace (const workspace &) = delete;
+	workspace &operator = (const workspace &) = delete;
+	~workspace () { release(); }
+
+	/*
+		Returns a buffer of at least size bytes aligned to HUGE_PAGE_SIZE(hence to 64 bytes), which stays valid until reserve() with a larger size.
+		Returns nullptr if the memory cannot be mapped, leaving the workspace empty
+	*/
+	void *reserve(size_t size) {
+		if (size <= capacity) return head;
+		release();
+		const size_t new_capacity = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+		void *ptr = mmap(nullptr, new_capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+		if (ptr != MAP_FAILED) {
+			map_head = head = (char *) ptr;
+			map_size = capacity = new_capacity;
+			hugetlb = true;
+			return head;
+		}
+		// one more huge page to align the start
+		ptr = mmap(nullptr, new_capacity + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (ptr == MAP_FAILED) return nullptr;
+		map_head = (char *) ptr;
+		map_size = new_capacity + HUGE_PAGE_SIZE;
+		head = map_head + (HUGE_PAGE_SIZE - (uintptr_t) map_head % HUGE_PAGE_SIZE) % HUGE_PAGE_SIZE;
+		capacity = new_capacity;
+#ifdef MADV_HUGEPAGE
+		madvise(head, capacity, MADV_HUGEPAGE);
+#endif
+		const size_t page_size = sysconf(_SC_PAGESIZE);
+		for (size_t offset = 0; offset < capacity; offset += page_size) ((volatile char *) head)[offset] = 0;
+		return head;
+	}
+	void release() {
+		if (map_head) munmap(map_head, map_size);
+		map_head = head = nullptr;
+		map_size = capacity = 0;
+		hugetlb = false;
+	}
+	size_t size() const { return capacity; }
+	// whether the buffer is on explicit huge pages; transparent huge pages are up to the kernel(see AnonHugePages in /proc/meminfo)
+	bool is_hugetlb() const { return hugetlb; }
+private:
+	char *map_head = nullptr;
+	size_t map_size = 0;
+	char *head = nullptr;
+	size_t capacity = 0;
+	bool hugetlb = false;
+};
+
+} // namespace storage
+} // namespace quick_floyd_warshall
@@ -1,300 +1,2565 @@
 #pragma once
 #include <cassert>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <cstdio>
 #include <string>
+#include <algorithm>
 #include <memory>
 #include <type_traits>
 #include <limits>
+#include <vector>
+#include <iterator>
+#include <array>
+#include <random>
+#include <chrono>
 #include "internal/vectorize.h"
+#include "internal/thread_pool.h"
+#include "internal/tuning.h"
+#include "internal/negative_cycle.h"
+#include "internal/mapped_file.h"
+#include "internal/sparsity.h"
+#include "internal/observer.h"
+#include "internal/workspace.h"
+#include "internal/transport.h"
+#include "internal/semiring.h"
+#include "internal/recursion.h"
 
 namespace quick_floyd_warshall {
 
 template <class T, class = void> struct is_complete : std::false_type {};
 template <class T> struct is_complete<T, decltype(void(sizeof(T)))> : std::true_type {};
 
+/*
+	the distance of unreachable pairs: half the maximum value for signed integers so that INF + INF doesn't overflow,
+	infinity for floating-point types, and the maximum value for unsigned integers, where the sums saturate at INF
+*/
+template<typename T> constexpr T inf_value() {
+	return std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() :
+		std::is_unsigned<T>::value ? std::numeric_limits<T>::max() : std::numeric_limits<T>::max() / 2;
+}
+
 template<typename T> struct floyd_warshall_naive {
 	using value_t = T;
-	static constexpr T INF = std::numeric_limits<T>::max() / 2;
-	static std::string get_description() { return "naive<int" + std::to_string(sizeof(value_t) * 8) + "_t>"; }
+	static constexpr T INF = inf_value<T>();
+	static std::string get_description() { return "naive<" + vectorize::type_to_str<value_t>() + ">"; }
 	static void run(int n, const T *input_matrix, T *output_matrix, bool symmetric = false) {
 		(void) symmetric;
-		T *buf = (T *) malloc(n * n * sizeof(T));
-		memcpy(buf, input_matrix, n * n * sizeof(T));
-		for (int k = 0; k < n; k++) for (int i = 0; i < n; i++) for (int j = 0; j < n; j++) 
-			buf[i * n + j] = std::min<T>(buf[i * n + j], buf[i * n + k] + buf[k * n + j]);
-		memcpy(output_matrix, buf, n * n * sizeof(T));
+		const size_t n_elements = (size_t) n * n;
+		T *buf = (T *) malloc(n_elements * sizeof(T));
+		memcpy(buf, input_matrix, n_elements * sizeof(T));
+		for (int k = 0; k < n; k++) for (int i = 0; i < n; i++) {
+			T *row_i = buf + (size_t) i * n;
+			const T *row_k = buf + (size_t) k * n;
+			for (int j = 0; j < n; j++) row_i[j] = std::min<T>(row_i[j], add(row_i[k], row_k[j], std::is_unsigned<T>()));
+		}
+		memcpy(output_matrix, buf, n_elements * sizeof(T));
 		free(buf);
 	}
+private:
+	static T add(T a, T b, std::false_type) { return a + b; }
+	static T add(T a, T b, std::true_type) { return a > INF - b ? INF : T(a + b); }
 };
 
 using InstSet = vectorize::InstSet;
 
-template<InstSet inst_set, typename T, int unroll_type> struct floyd_warshall {
+template<InstSet inst_set, typename T, int unroll_type, int block_size> struct parallel_floyd_warshall;
+template<InstSet inst_set, typename T, int unroll_type, int block_size> class incremental_floyd_warshall;
+template<InstSet inst_set, typename T, int unroll_type, int block_size> struct out_of_core_floyd_warshall;
+template<InstSet inst_set, typename T, int unroll_type, int block_size> class reusable_floyd_warshall;
+template<InstSet inst_set, typename T, int unroll_type, int block_size> class distributed_floyd_warshall;
+
+/*
+	Pointers to the BxB blocks of an n_blocks * n_blocks block matrix placed in the order like this(each [i][j] is a block):
+		[0][0], [0][1], [1][0], [1][1],
+		[0][2], [0][3], [1][2], [1][3],
+		[2][0], [2][1], [3][0], [3][1],
+		[2][2], [2][3], [3][2], [3][3],
+		[0][4], [0][5], [1][4], [1][5], ...
+	(the Z-order of the n_blocks_power2 * n_blocks_power2 blocks with the ones outside n_blocks * n_blocks skipped)
+	so that the blocks used together in the recursion of FWR are close to each other.
+	The position of a block is computed by following the recursive split down to the block in O(log n_blocks)
+	instead of being stored, so the table takes no memory for any n_blocks.
+	If triangular, only the blocks [i][j] with i <= j are stored(in the same order), which halves the memory for symmetric matrices;
+	[j][i] is then represented by [i][j] transposed and cannot be looked up.
+*/
+template<typename T, int block_size> class block_table {
+public:
+	block_table () = default;
+	block_table (T *head, int n_blocks, int n_blocks_power2, bool triangular = false) :
+		head(head), n_blocks(n_blocks), n_blocks_power2(n_blocks_power2), triangular(triangular) {}
+	
+	T *operator () (int block_row, int block_column) const { return head + index(block_row, block_column) * block_size * block_size; }
+	// the position of the block, i.e. the number of the blocks placed before it
+	size_t index(int block_row, int block_column) const {
+		assert(!triangular || block_row <= block_column);
+		size_t position = 0; // the number of blocks placed before the block
+		int row = 0, column = 0; // the top-left block of the current square
+		for (int half = n_blocks_power2 >> 1; half; half >>= 1) {
+			const bool lower = block_row >= row + half, right = block_column >= column + half;
+			// the quadrants are placed in the order upper left, upper right, lower left, lower right
+			if (lower) position += count(row, column, half) + count(row, column + half, half);
+			if (right) position += count(lower ? row + half : row, column, half);
+			if (lower) row += half;
+			if (right) column += half;
+		}
+		return position;
+	}
+	T *data() const { return head; }
+	bool is_triangular() const { return triangular; }
+	// the number of blocks stored
+	size_t size() const { return count(0, 0, n_blocks_power2); }
+private:
+	T *head = nullptr;
+	int n_blocks = 0;
+	int n_blocks_power2 = 0;
+	bool triangular = false;
+	
+	// the number of existing blocks in [start, start + half) in a dimension
+	int extent(int start, int half) const { return std::max(0, std::min(half, n_blocks - start)); }
+	// the number of stored blocks in the half * half square from [row][column], which is either on the diagonal or off it entirely
+	size_t count(int row, int column, int half) const {
+		if (!triangular || row < column) return (size_t) extent(row, half) * extent(column, half);
+		if (row > column) return 0;
+		const size_t length = extent(row, half);
+		return length * (length + 1) / 2;
+	}
+};
+
+/*
+	src_n * src_n matrix stored natively in the layout the kernels of floyd_warshall<*, T, *, block_size> work on:
+	split into block_size x block_size blocks placed in the Z-order(see block_table), with every element encoded(see encode())
+	and the padding up to a multiple of block_size filled with INF.
+	floyd_warshall::run(blocked_matrix &) solves it in place, so a pipeline can keep its matrices in this layout
+	across repeated solves and pre-/post-processing without converting from/to the row-major layout each time.
+*/
+template<typename T, int block_size = 64> class blocked_matrix {
+	template<InstSet, typename, int, int, class> friend struct floyd_warshall;
+	template<InstSet, typename, int, int> friend class incremental_floyd_warshall;
+	template<InstSet, typename, int, int> friend struct out_of_core_floyd_warshall;
+	template<InstSet, typename, int, int> friend class reusable_floyd_warshall;
+	template<typename, int> friend class distance_file;
+public:
+	static constexpr T INF = inf_value<T>();
+	using value_t = T;
+	
+	/*
+		The value stored for x, which is also its inverse.
+		The elements are negated so that the kernels handle everything with max instead of min.
+		This is because chmax(mem, reg) can be implemented faster than chmin(mem, reg) with avx2+int64_t
+		The cost of negation should be negligible for other combinations, where this trick is irrelevant
+		Unsigned types are complemented instead, which reverses the order in the same way
+		and maps INF to 0, so that the saturating + of vector_t never goes below it
+	*/
+	static T encode(T x) { return encode(x, std::is_unsigned<T>()); }
+	
+	blocked_matrix () = default;
+	// src_n vertices with no edges: INF except for the zero diagonal
+	explicit blocked_matrix (int src_n) {
+		allocate(src_n);
+		import(nullptr);
+		for (int i = 0; i < src_n; i++) at(i, i) = encode(0);
+	}
+	// matrix : src_n * src_n row-major matrix in the same format as the input of floyd_warshall::run
+	blocked_matrix (int src_n, const T *matrix) {
+		allocate(src_n);
+		import(matrix);
+	}
+	blocked_matrix (const blocked_matrix &rhs) {
+		allocate(rhs.src_n, rhs.blocks.is_triangular());
+		if (src_n) memcpy(blocks.data(), rhs.blocks.data(), buffer_size());
+	}
+	blocked_matrix (blocked_matrix &&rhs) { swap(rhs); }
+	blocked_matrix &operator = (blocked_matrix rhs) { swap(rhs); return *this; }
+	~blocked_matrix () { free(buffer_org); }
+	void swap(blocked_matrix &rhs) {
+		std::swap(src_n, rhs.src_n);
+		std::swap(n_blocks, rhs.n_blocks);
+		std::swap(n_blocks_power2, rhs.n_blocks_power2);
+		std::swap(buffer_org, rhs.buffer_org);
+		file.swap(rhs.file);
+		std::swap(blocks, rhs.blocks);
+	}
+	/*
+		Replaces the content with a src_n * src_n matrix kept in the file at path, which is memory-mapped
+		so that the matrix can be larger than the memory(see out_of_core_floyd_warshall).
+		If initialize, the file is created or truncated and the matrix is initialized like blocked_matrix(src_n),
+		otherwise the file must have been written by a blocked_matrix with the same src_n, T, and block_size.
+		Returns false if the file cannot be opened or mapped, leaving the matrix empty.
+		The content is written back to the file by the OS, at the latest when the matrix is destroyed.
+		Copies of the matrix are held in memory
+	*/
+	bool map_file(const std::string &path, int src_n, bool initialize) {
+		*this = blocked_matrix();
+		if (!layout(src_n) || !file.open(path, buffer_size(), initialize)) {
+			*this = blocked_matrix();
+			return src_n == 0;
+		}
+		blocks = block_table<T, B>((T *) file.data(), n_blocks, n_blocks_power2);
+		if (initialize) {
+			import(nullptr);
+			for (int i = 0; i < src_n; i++) at(i, i) = encode(0);
+		}
+		return true;
+	}
+	bool is_mapped() const { return file.is_open(); }
+	
+	int size() const { return src_n; }
+	T get(int i, int j) const { return encode(at(i, j)); }
+	void set(int i, int j, T value) { at(i, j) = encode(value); }
+	// writes the src_n * src_n row-major matrix in the same format as the output of floyd_warshall::run
+	void to_matrix(T *matrix) const { to_matrix(matrix, false); }
+	
+	// iterates over the (decoded) elements of a row in the order of the columns
+	class row_iterator {
+	public:
+		using iterator_category = std::input_iterator_tag;
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const T *;
+		using reference = T;
+		
+		row_iterator (const blocked_matrix *matrix, int row, int column) : matrix(matrix), row(row), column(column) { find_block(); }
+		T operator * () const { return encode(block[column % B]); }
+		row_iterator &operator ++ () {
+			if (++column % B == 0) find_block();
+			return *this;
+		}
+		row_iterator operator ++ (int) { row_iterator res = *this; ++*this; return res; }
+		bool operator == (const row_iterator &rhs) const { return column == rhs.column; }
+		bool operator != (const row_iterator &rhs) const { return column != rhs.column; }
+	private:
+		const blocked_matrix *matrix;
+		int row;
+		int column;
+		const T *block = nullptr; // the row in the block containing column
+		
+		void find_block() { if (column < matrix->src_n) block = matrix->blocks(row / B, column / B) + (row % B) * B; }
+	};
+	struct row_range {
+		row_iterator first, last;
+		row_iterator begin() const { return first; }
+		row_iterator end() const { return last; }
+	};
+	// row i as a range, e.g. for (T dist : matrix.row(i))
+	row_range row(int i) const { return { row_iterator(this, i, 0), row_iterator(this, i, src_n) }; }
+private:
+	static constexpr int B = block_size;
+	int src_n = 0;
+	int n_blocks = 0; // number of BxB blocks in a row
+	int n_blocks_power2 = 0; // smallest power of 2 >= n_blocks
+	void *buffer_org = nullptr;
+	storage::mapped_file file; // used instead of buffer_org if mapped
+	block_table<T, block_size> blocks;
+	
+	static T encode(T x, std::false_type) { return T(-x); }
+	static T encode(T x, std::true_type) { return T(~x); }
+	
+	/*
+		src_n * src_n symmetric matrix in the triangular layout(see block_table), with only the blocks on and above the diagonal stored.
+		Only used by floyd_warshall::run with symmetric, which never asks for the rows(row_iterator needs every block).
+		The buffer is taken from workspace if not null(see allocate()), and the elements are stored as they are if raw(see import())
+	*/
+	blocked_matrix (int src_n, const T *matrix, bool triangular, storage::workspace *workspace = nullptr, bool raw = false) {
+		allocate(src_n, triangular, workspace);
+		import(matrix, raw);
+	}
+	T &at(int i, int j) const {
+		if (blocks.is_triangular() && i / B > j / B) std::swap(i, j);
+		return blocks(i / B, j / B)[(i % B) * B + j % B];
+	}
+	size_t buffer_size() const { return buffer_size(blocks.is_triangular()); }
+	size_t buffer_size(bool triangular) const { return buffer_size(n_blocks, triangular); }
+	static size_t buffer_size(int n_blocks, bool triangular) {
+		const size_t n_stored_blocks = triangular ? (size_t) n_blocks * (n_blocks + 1) / 2 : (size_t) n_blocks * n_blocks;
+		return n_stored_blocks * B * B * sizeof(T);
+	}
+	// sets the sizes for src_n * src_n elements; returns false if there is nothing to store
+	bool layout(int src_n) {
+		assert(0 <= src_n);
+		this->src_n = src_n;
+		if (src_n == 0) return false;
+		n_blocks = (src_n + B - 1) / B;
+		n_blocks_power2 = 1;
+		while (n_blocks_power2 < n_blocks) n_blocks_power2 *= 2;
+		return true;
+	}
+	/*
+		allocates the 64-byte aligned buffer for src_n * src_n elements and places the blocks in it.
+		If workspace is not null, the buffer is taken from it instead(and not owned by the matrix) unless it cannot grow
+	*/
+	void allocate(int src_n, bool triangular = false, storage::workspace *workspace = nullptr) {
+		if (!layout(src_n)) return;
+		void *aligned = workspace ? workspace->reserve(buffer_size(triangular)) : nullptr;
+		if (!aligned) {
+			size_t reordered_buffer_size = buffer_size(triangular) + 64;
+			buffer_org = malloc(reordered_buffer_size);
+			assert(buffer_org);
+			void *reordered = buffer_org;
+			aligned = std::align(64, buffer_size(triangular), reordered, reordered_buffer_size);
+			assert(aligned);
+		}
+		blocks = block_table<T, B>((T *) aligned, n_blocks, n_blocks_power2, triangular);
+	}
+	// the value of an element, which is stored as it is if raw(see semiring::max_min)
+	static T decode(T x, bool raw) { return raw ? x : encode(x); }
+	// to_matrix() for the elements stored raw or not
+	void to_matrix(T *matrix, bool raw) const {
+		for (int block_row = 0; block_row < n_blocks; block_row++) for (int block_column = 0; block_column < n_blocks; block_column++) {
+			// the transposed block is read in the triangular layout
+			const bool transposed = blocks.is_triangular() && block_row > block_column;
+			const T *src = transposed ? blocks(block_column, block_row) : blocks(block_row, block_column);
+			int length = std::min(B, src_n - block_column * B);
+			for (int y = 0; y < B && block_row * B + y < src_n; y++) {
+				T *dst = matrix + (size_t) (block_row * B + y) * src_n + block_column * B;
+				if (transposed) for (int x = 0; x < length; x++) dst[x] = decode(src[x * B + y], raw);
+				else for (int x = 0; x < length; x++) dst[x] = decode(src[y * B + x], raw);
+			}
+		}
+	}
+	
+	/*
+		encodes matrix(src_n * src_n, row-major) into the blocks and fills the padding with INF; all INF if matrix is null.
+		The elements are stored as they are if raw. Only the upper triangle of blocks is read in the triangular layout
+	*/
+	void import(const T *matrix, bool raw = false) {
+		for (int block_row = 0; block_row < n_blocks; block_row++) for (int block_column = 0; block_column < n_blocks; block_column++) {
+			if (blocks.is_triangular() && block_row > block_column) continue;
+			T *dst = blocks(block_row, block_column);
+			for (int y = 0; y < B; y++) {
+				int i = block_row * B + y;
+				int length = matrix && i < src_n ? std::min(B, src_n - block_column * B) : 0;
+				for (int x = 0; x < length; x++) dst[y * B + x] = decode(matrix[(size_t) i * src_n + block_column * B + x], raw);
+				for (int x = length; x < B; x++) dst[y * B + x] = encode(INF);
+			}
+		}
+	}
+};
+
+/*
+	Versioned on-disk format of a src_n * src_n distance matrix, and a reader answering the queries on it through mmap,
+	so that a query server starts without loading the file and only the pages of the tiles asked for are read.
+	The file is a header(see header_t) followed by the tiles, i.e. the block_size x block_size blocks of blocked_matrix
+	in the same order(see block_table), so that write() reads the blocked_matrix sequentially.
+	The values are the distances(as in the output of floyd_warshall::run) in the byte order of the machine.
+	 - symmetric : only the tiles on and above the diagonal are stored, and (j, i) is read from (i, j)
+	 - compressed : a table of the offsets of the tiles comes first, and each tile(see tile_header_t) is stored as its smallest value
+		and the differences from it packed in the fewest bits for the largest one, with the all-ones code reserved for INF.
+		e.g. a tile of distances within [d, d + 254] takes 1 byte per element and an all-INF tile takes 16 bytes.
+		Only for the integer types; the flag is ignored for the floating-point types
+	The reader checks the header against T and block_size, so the file must be read with the same ones it was written with
+*/
+template<typename T, int block_size = 64> class distance_file {
 public:
-	static constexpr T INF = std::numeric_limits<T>::max() / 2;
+	static constexpr T INF = inf_value<T>();
+	using value_t = T;
+	static constexpr uint32_t VERSION = 1;
+	
+	/*
+		Writes matrix to the file at path, streaming the tiles out of its buffer one by one.
+		A matrix in the triangular layout is always written as symmetric; otherwise symmetric requires matrix to be symmetric.
+		Returns false if the file cannot be written
+	*/
+	static bool write(const std::string &path, const blocked_matrix<T, block_size> &matrix, bool symmetric = false, bool compressed = false) {
+		symmetric |= matrix.blocks.is_triangular();
+		compressed &= std::is_integral<T>::value;
+		header_t header = make_header(matrix.src_n, symmetric, compressed);
+		// the tiles in the order they are stored
+		const block_table<T, B> tiles(nullptr, matrix.n_blocks, matrix.n_blocks_power2, symmetric);
+		std::vector<std::pair<int, int> > order(header.n_tiles);
+		for (int block_row = 0; block_row < matrix.n_blocks; block_row++)
+			for (int block_column = symmetric ? block_row : 0; block_column < matrix.n_blocks; block_column++)
+				order[tiles.index(block_row, block_column)] = { block_row, block_column };
+		
+		FILE *fp = fopen(path.c_str(), "wb");
+		if (!fp) return false;
+		bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+		std::vector<uint64_t> offsets(compressed ? header.n_tiles + 1 : 0, 0);
+		// the table is written again once the offsets are known
+		if (compressed) ok = ok && fwrite(offsets.data(), sizeof(uint64_t), offsets.size(), fp) == offsets.size();
+		uint64_t offset = sizeof(header_t) + offsets.size() * sizeof(uint64_t);
+		std::vector<T> tile(B * B);
+		std::vector<uint64_t> record;
+		for (size_t t = 0; ok && t < order.size(); t++) {
+			const T *src = matrix.blocks(order[t].first, order[t].second);
+			for (int i = 0; i < B * B; i++) tile[i] = matrix_t::encode(src[i]);
+			if (!compressed) {
+				ok = fwrite(tile.data(), sizeof(T), B * B, fp) == (size_t) B * B;
+				continue;
+			}
+			compress(tile.data(), record);
+			offsets[t] = offset;
+			offset += record.size() * sizeof(uint64_t);
+			ok = fwrite(record.data(), sizeof(uint64_t), record.size(), fp) == record.size();
+		}
+		if (compressed) {
+			offsets.back() = offset;
+			ok = ok && fseek(fp, sizeof(header_t), SEEK_SET) == 0 && fwrite(offsets.data(), sizeof(uint64_t), offsets.size(), fp) == offsets.size();
+		}
+		ok = fclose(fp) == 0 && ok;
+		if (!ok) remove(path.c_str());
+		return ok;
+	}
+	// writes a src_n * src_n row-major matrix(e.g. the output of floyd_warshall::run), which is converted into a blocked_matrix first
+	static bool write(const std::string &path, int src_n, const T *matrix, bool symmetric = false, bool compressed = false) {
+		return write(path, matrix_t(src_n, matrix), symmetric, compressed);
+	}
+	
+	distance_file () = default;
+	/*
+		Maps the file at path written by write() for the queries.
+		Returns false if it cannot be mapped or is not a valid file of the version for T and block_size, leaving nothing open
+	*/
+	bool open(const std::string &path) {
+		close();
+		if (!file.open_read_only(path) || !validate()) {
+			close();
+			return false;
+		}
+		return true;
+	}
+	void close() {
+		file.close();
+		header = header_t();
+	}
+	bool is_open() const { return file.is_open(); }
+	int size() const { return header.src_n; }
+	bool is_symmetric() const { return header.flags & SYMMETRIC; }
+	bool is_compressed() const { return header.flags & COMPRESSED; }
+	
+	// the distance from u to v; reads one element of a tile
+	T distance(int u, int v) const {
+		assert(0 <= u && u < size() && 0 <= v && v < size());
+		if (is_symmetric() && u / B > v / B) std::swap(u, v);
+		return element(tiles.index(u / B, v / B), (u % B) * B + v % B);
+	}
+	// writes row u, i.e. distance(u, v) for v in [0, size()), to row; only the row of tiles containing u is read
+	void read_row(int u, T *row) const {
+		assert(0 <= u && u < size());
+		for (int block_column = 0; block_column * B < size(); block_column++) {
+			const int length = std::min(B, size() - block_column * B);
+			T *dst = row + block_column * B;
+			if (is_symmetric() && u / B > block_column) {
+				const size_t tile = tiles.index(block_column, u / B);
+				for (int x = 0; x < length; x++) dst[x] = element(tile, x * B + u % B);
+			} else {
+				const size_t tile = tiles.index(u / B, block_column);
+				for (int x = 0; x < length; x++) dst[x] = element(tile, (u % B) * B + x);
+			}
+		}
+	}
+private:
+	static constexpr int B = block_size;
+	using matrix_t = blocked_matrix<T, B>;
+	static constexpr uint32_t SYMMETRIC = 1, COMPRESSED = 2;
+	// the width of the tiles stored as they are(see tile_header_t)
+	static constexpr uint64_t RAW_WIDTH = sizeof(T) * 8;
+	
+	struct header_t {
+		char magic[8]; // "QFWDIST"
+		uint32_t version;
+		uint32_t flags; // SYMMETRIC | COMPRESSED
+		int32_t src_n;
+		int32_t tile_size; // block_size, the width of a tile
+		char type[16]; // vectorize::type_to_str<T>()
+		uint64_t inf; // INF in the first sizeof(T) bytes, e.g. to tell the version of the library that wrote it
+		uint64_t n_tiles;
+		uint64_t reserved;
+	};
+	static_assert(sizeof(header_t) == 64, "");
+	/*
+		A compressed tile is tile_header_t followed by
+		 - nothing if width = 0, where every element is INF
+		 - the B * B elements as they are, padded to a multiple of 8 bytes, if width = RAW_WIDTH
+		 - otherwise the B * B codes of width bits in 64-bit words from the lowest bit, where code c is base + c, and 2^width - 1 is INF
+	*/
+	struct tile_header_t {
+		uint64_t base; // in the first sizeof(T) bytes
+		uint64_t width;
+	};
+	
+	storage::mapped_file file;
+	header_t header = header_t();
+	block_table<T, B> tiles; // only for the positions of the tiles
+	
+	static header_t make_header(int src_n, bool symmetric, bool compressed) {
+		header_t header = header_t();
+		memcpy(header.magic, "QFWDIST", 8);
+		header.version = VERSION;
+		header.flags = (symmetric ? SYMMETRIC : 0) | (compressed ? COMPRESSED : 0);
+		header.src_n = src_n;
+		header.tile_size = B;
+		const std::string type = vectorize::type_to_str<T>();
+		memcpy(header.type, type.c_str(), type.size());
+		const T inf = INF;
+		memcpy(&header.inf, &inf, sizeof(T));
+		const uint64_t n_blocks = (src_n + B - 1) / B;
+		header.n_tiles = symmetric ? n_blocks * (n_blocks + 1) / 2 : n_blocks * n_blocks;
+		return header;
+	}
+	// x - base as an unsigned integer(x >= base), and its inverse; exact for the differences up to 2^64 - 1
+	using wide_t = typename std::conditional<std::is_signed<T>::value, int64_t, uint64_t>::type;
+	static uint64_t difference(T x, T base) { return (uint64_t) (wide_t) x - (uint64_t) (wide_t) base; }
+	static T add(T base, uint64_t difference) { return (T) (wide_t) ((uint64_t) (wide_t) base + difference); }
+	// the bytes of a compressed tile of width in the 64-bit words, excluding tile_header_t
+	static size_t record_words(uint64_t width) {
+		if (width == RAW_WIDTH) return (B * B * sizeof(T) + 7) / 8;
+		return (B * B * width + 63) / 64;
+	}
+	// writes the compressed tile(see tile_header_t) into record
+	static void compress(const T *tile, std::vector<uint64_t> &record) {
+		bool all_inf = true;
+		T base = 0, largest = 0;
+		for (int i = 0; i < B * B; i++) if (tile[i] != INF) {
+			if (all_inf || tile[i] < base) base = tile[i];
+			if (all_inf || tile[i] > largest) largest = tile[i];
+			all_inf = false;
+		}
+		// the width for the codes up to difference(largest, base) + 1(INF)
+		const uint64_t max_code = difference(largest, base) + 1;
+		uint64_t width = all_inf ? 0 : max_code == 0 ? 64 : 64 - __builtin_clzll(max_code);
+		if (width >= RAW_WIDTH) width = RAW_WIDTH;
+		
+		tile_header_t tile_header = { 0, width };
+		memcpy(&tile_header.base, &base, sizeof(T));
+		record.assign(2 + record_words(width), 0);
+		memcpy(record.data(), &tile_header, sizeof(tile_header));
+		uint64_t *words = record.data() + 2;
+		if (width == RAW_WIDTH) {
+			memcpy(words, tile, B * B * sizeof(T));
+			return;
+		}
+		const uint64_t inf_code = ((uint64_t) 1 << width) - 1;
+		for (int i = 0; width && i < B * B; i++) {
+			const uint64_t code = tile[i] == INF ? inf_code : difference(tile[i], base);
+			const uint64_t bit = (uint64_t) i * width;
+			words[bit / 64] |= code << (bit % 64);
+			if (bit % 64 + width > 64) words[bit / 64 + 1] |= code >> (64 - bit % 64);
+		}
+	}
+	// element position(y * B + x) of the tile at the position
+	T element(size_t tile, int position) const {
+		const char *head = (const char *) file.data();
+		if (!is_compressed()) return ((const T *) (head + sizeof(header_t)))[tile * B * B + position];
+		const uint64_t offset = ((const uint64_t *) (head + sizeof(header_t)))[tile];
+		tile_header_t tile_header;
+		memcpy(&tile_header, head + offset, sizeof(tile_header));
+		const uint64_t *words = (const uint64_t *) (head + offset + sizeof(tile_header_t));
+		const uint64_t width = tile_header.width;
+		if (width == 0) return INF;
+		if (width == RAW_WIDTH) return ((const T *) words)[position];
+		const uint64_t bit = (uint64_t) position * width;
+		uint64_t code = words[bit / 64] >> (bit % 64);
+		if (bit % 64 + width > 64) code |= words[bit / 64 + 1] << (64 - bit % 64);
+		const uint64_t inf_code = ((uint64_t) 1 << width) - 1;
+		code &= inf_code;
+		if (code == inf_code) return INF;
+		T base;
+		memcpy(&base, &tile_header.base, sizeof(T));
+		return add(base, code);
+	}
+	// reads the header and checks that the tiles are within the file
+	bool validate() {
+		if (file.size() < sizeof(header_t)) return false;
+		memcpy(&header, file.data(), sizeof(header_t));
+		if (header.src_n < 0 || header.flags & ~(SYMMETRIC | COMPRESSED)) return false;
+		const header_t expected = make_header(header.src_n, is_symmetric(), is_compressed());
+		if (memcmp(&header, &expected, sizeof(header_t))) return false;
+		const int n_blocks = (size() + B - 1) / B;
+		int n_blocks_power2 = 1;
+		while (n_blocks_power2 < n_blocks) n_blocks_power2 *= 2;
+		tiles = block_table<T, B>(nullptr, n_blocks, n_blocks_power2, is_symmetric());
+		
+		const uint64_t n_tiles = header.n_tiles;
+		if (!is_compressed()) return file.size() >= sizeof(header_t) + n_tiles * B * B * sizeof(T);
+		if (file.size() < sizeof(header_t) + (n_tiles + 1) * sizeof(uint64_t)) return false;
+		const char *head = (const char *) file.data();
+		const uint64_t *offsets = (const uint64_t *) (head + sizeof(header_t));
+		if (offsets[0] != sizeof(header_t) + (n_tiles + 1) * sizeof(uint64_t) || offsets[n_tiles] > file.size()) return false;
+		for (uint64_t t = 0; t < n_tiles; t++) {
+			if (offsets[t] % 8 || offsets[t] > offsets[t + 1] || offsets[t + 1] - offsets[t] < sizeof(tile_header_t)) return false;
+			tile_header_t tile_header;
+			memcpy(&tile_header, head + offsets[t], sizeof(tile_header));
+			if (tile_header.width > RAW_WIDTH ||
+				offsets[t + 1] - offsets[t] != sizeof(tile_header_t) + record_words(tile_header.width) * sizeof(uint64_t)) return false;
+		}
+		return true;
+	}
+};
+
+/*
+	Semiring(see semiring::min_plus) chooses the path problem: the shortest paths by default,
+	the minimax paths with semiring::min_max, or the widest paths with semiring::max_min, all with the same kernels.
+	Only run() takes the other semirings; run_sparse(), run_components(), and run(blocked_matrix &) accept only the ones not raw(i.e. not semiring::max_min)
+*/
+template<InstSet inst_set, typename T, int unroll_type, int block_size = 64, class Semiring = semiring::min_plus> struct floyd_warshall {
+	friend struct parallel_floyd_warshall<inst_set, T, unroll_type, block_size>;
+	friend class incremental_floyd_warshall<inst_set, T, unroll_type, block_size>;
+	friend struct out_of_core_floyd_warshall<inst_set, T, unroll_type, block_size>;
+	friend class reusable_floyd_warshall<inst_set, T, unroll_type, block_size>;
+	friend class distributed_floyd_warshall<inst_set, T, unroll_type, block_size>;
+public:
+	static constexpr T INF = inf_value<T>();
+	// run_checked() saturates the distances at -SATURATION
+	static constexpr T SATURATION = std::is_floating_point<T>::value ? std::numeric_limits<T>::max() / 4 : INF / 2;
 	using value_t = T;
 	
 	static std::string get_description() {
-		return "opt<" + vectorize::inst_set_to_str(inst_set) + ", " "int" + std::to_string(sizeof(value_t) * 8) + "_t, "
-			+ std::to_string(unroll_type) + ">"; 
+		return "opt<" + vectorize::inst_set_to_str(inst_set) + ", " + vectorize::type_to_str<value_t>() + ", "
+			+ std::to_string(unroll_type) + ", " + std::to_string(block_size) + (is_min_plus ? "" : ", " + Semiring::name()) + ">"; 
 	}
 private:
-	static constexpr int B = 64; // block size
+	static constexpr int B = block_size;
 	using vector_t = vectorize::vector_t<inst_set, T>;
 	
 	static_assert(is_complete<vector_t>::value, "Invalid inst_set or T");
-	static_assert(B % (vector_t::SIZE / sizeof(T)) == 0, "Invalid B value");
+	static_assert(B % (vector_t::SIZE / sizeof(T)) == 0 && B % 4 == 0, "Invalid block_size value");
 	static_assert(unroll_type >= 0 && unroll_type <= 3, "Invalid unroll_type value");
 	
+	using matrix_t = blocked_matrix<T, B>;
+	using blocks_t = block_table<T, B>;
+	using mask_t = sparsity::block_mask;
+	static T encode(T x) { return matrix_t::encode(x); }
+	static vector_t extend(const vector_t &lhs, const vector_t &rhs) { return Semiring::extend(lhs, rhs); }
+	static constexpr bool is_min_plus = std::is_same<Semiring, semiring::min_plus>::value;
+	
+	// the blocks of an FWI call, prefetched while the previous call runs(see solve())
+	struct prefetch_t { const T *blocks[3]; };
+	// the next-hop blocks of a, b for MaxPlusMulTile in the path mode(see FWI_path()); no_path_t runs it without them
+	struct no_path_t {};
+	template<typename index_t> struct path_t {
+		index_t *a_next;
+		const index_t *b_next;
+	};
+	// the tile of MaxPlusMul for each unroll_type: (rows of a, rows of c) = (2, 2), (2, 4), (4, 2), (4, 4)
+	static constexpr int TILE_ROWS = unroll_type >= 2 ? 4 : 2;
+	static constexpr int TILE_DEPTH = unroll_type % 2 ? 4 : 2;
 	/*
-		MaxPlusMul?(a, b, c) :
+		MaxPlusMul(a, b, c, next) :
 		 - [a, a + B * B), [b, b + B * B), [c, c + B * B) must not overlap
 		 - equivalent to:
 			for all i, j in [0, B):
-				a[i * B + j] = max(a[i * B + j], max{b[i * B + k] + c[k * B + j] | k in [0, B)})
+				a[i * B + j] = max(a[i * B + j], max{extend(b[i * B + k], c[k * B + j]) | k in [0, B)})
+			where extend is + for semiring::min_plus(see Semiring)
+		MaxPlusMulTile<MI, MK> is generated for a tile of MI rows of a and MK rows of c:
+		the MI x MK coefficients of b are broadcast into the registers, and each vector of the MK rows of c is extended by them
+		and reduced into the MI rows of a by a tree of max, so a tile takes MI * MK + MK vector registers.
+		If next is not null, its blocks are prefetched into L2 a few lines per tile.
+		With Path = path_t<index_t>, the MK candidates are reduced one by one instead(see update_row()),
+		so that the comparison masks also update the next-hop block path.a_next from path.b_next
 	*/
-	static void MaxPlusMul0(T *a, T *b, T *c) {
+	template<int MI, int MK, typename Path = no_path_t> static void MaxPlusMulTile(T *a, T *b, T *c, const prefetch_t *next,
+		const Path &path = Path()) {
+		
 		constexpr int n = B;
-		for (int k = 0; k < n; k += 2) for (int i = 0; i < n; i += 2) {
-			vector_t coef00(b[(i + 0) * n + (k + 0)]);
-			vector_t coef01(b[(i + 0) * n + (k + 1)]);
-			vector_t coef10(b[(i + 1) * n + (k + 0)]);
-			vector_t coef11(b[(i + 1) * n + (k + 1)]);
+		constexpr int LINES = (B * B * sizeof(T) + 63) / 64; // cache lines of a block
+		constexpr int LINES_PER_TILE = (3 * LINES + (B / MI) * (B / MK) - 1) / ((B / MI) * (B / MK));
+		static_assert(B % MI == 0 && B % MK == 0, "Invalid tile size");
+		int line = 0;
+		for (int k = 0; k < n; k += MK) for (int i = 0; i < n; i += MI) {
+			vector_t coef[MI][MK];
+			vectorize::unroll<MI>::run([&] (int y) {
+				vectorize::unroll<MK>::run([&] (int x) { coef[y][x] = vector_t(b[(i + y) * n + (k + x)]); });
+			});
+			if (next) for (int end = std::min(line + LINES_PER_TILE, 3 * LINES); line < end; line++)
+				__builtin_prefetch((const char *) next->blocks[line / LINES] + line % LINES * 64, 0, 2);
 			
 			T *aa = a + i * n;
 			T *bb = c + k * n;
 			for (int j = 0; j < n; j += vector_t::SIZE / sizeof(T)) {
-				vector_t t0(bb + j);
-				vector_t t1(bb + n + j);
-				max(t0 + coef00, t1 + coef01).chmax_store(aa + j);
-				max(t0 + coef10, t1 + coef11).chmax_store(aa + n + j);
+				vector_t t[MK];
+				vectorize::unroll<MK>::run([&] (int x) { t[x] = vector_t(bb + x * n + j); });
+				vectorize::unroll<MI>::run([&] (int y) { update_row<MK>(aa + y * n + j, t, coef[y], path, (i + y) * n + j, (i + y) * n + k); });
 			}
 		}
 	}
-	static void MaxPlusMul1(T *a, T *b, T *c) {
-		constexpr int n = B;
-		for (int k = 0; k < n; k += 4) for (int i = 0; i < n; i += 2) {
-			vector_t coef00(b[(i + 0) * n + (k + 0)]);
-			vector_t coef01(b[(i + 0) * n + (k + 1)]);
-			vector_t coef02(b[(i + 0) * n + (k + 2)]);
-			vector_t coef03(b[(i + 0) * n + (k + 3)]);
-			vector_t coef10(b[(i + 1) * n + (k + 0)]);
-			vector_t coef11(b[(i + 1) * n + (k + 1)]);
-			vector_t coef12(b[(i + 1) * n + (k + 2)]);
-			vector_t coef13(b[(i + 1) * n + (k + 3)]);
-			
-			T *aa = a + i * n;
-			T *bb = c + k * n;
-			for (int j = 0; j < n; j += vector_t::SIZE / sizeof(T)) {
-				vector_t t0(bb + j);
-				vector_t t1(bb + n + j);
-				vector_t t2(bb + n + n + j);
-				vector_t t3(bb + n + n + n + j);
-				max(max(t0 + coef00, t1 + coef01), max(t2 + coef02, t3 + coef03)).chmax_store(aa + j);
-				max(max(t0 + coef10, t1 + coef11), max(t2 + coef12, t3 + coef13)).chmax_store(aa + n + j);
-			}
-		}
+	/*
+		update_row<MK>(ptr, t, coef, path, a_position, b_position) : a vector of a row of a in MaxPlusMulTile,
+		ptr[lane] = max(ptr[lane], max{extend(t[x], coef[x])[lane] | x in [0, MK)}), where ptr = a + a_position.
+		Without a path, the MK candidates are reduced by a tree of max.
+		With a path, they are compared with the current value one by one and path.a_next[a_position + lane] becomes
+		path.b_next[b_position + x] for the last x improving the lane(see update_next()), which is the same as the k-i-j order
+	*/
+	template<int MK> static void update_row(T *ptr, const vector_t *t, const vector_t *coef, const no_path_t &, int, int) {
+		vector_t sum[MK];
+		vectorize::unroll<MK>::run([&] (int x) { sum[x] = extend(t[x], coef[x]); });
+		for (int width = 1; width < MK; width *= 2) vectorize::unroll<MK>::run([&] (int x) {
+			if (x % (2 * width) == 0 && x + width < MK) sum[x] = max(sum[x], sum[x + width]);
+		});
+		sum[0].chmax_store(ptr);
+	}
+	template<int MK, typename index_t> static void update_row(T *ptr, const vector_t *t, const vector_t *coef, const path_t<index_t> &path,
+		int a_position, int b_position) {
+		
+		vector_t cur(ptr);
+		vectorize::unroll<MK>::run([&] (int x) {
+			vector_t candidate = extend(t[x], coef[x]);
+			update_next(greater(candidate, cur), path.a_next + a_position, path.b_next[b_position + x],
+				std::integral_constant<bool, sizeof(index_t) == sizeof(T)>());
+			cur = max(cur, candidate);
+		});
+		cur.store(ptr);
 	}
-	static void MaxPlusMul2(T *a, T *b, T *c) {
+	static void MaxPlusMul(T *a, T *b, T *c, const prefetch_t *next = nullptr) {
+		MaxPlusMulTile<TILE_ROWS, TILE_DEPTH>(a, b, c, next);
+	}
+	static void FWI(T *a, T *b, T *c) { FWI_prefetching(a, b, c, nullptr); }
+	// FWI(a, b, c) prefetching the blocks of next(if not null) for the call after it
+	static void FWI_prefetching(T *a, T *b, T *c, const prefetch_t *next) {
+		// compile the kernels for inst_set even if the corresponding target options are not given to the compiler
+		vectorize::target_region<inst_set>::call([a, b, c, next] () { FWI_kernel(a, b, c, next); });
+	}
+	static void FWI_kernel(T *a, T *b, T *c, const prefetch_t *next = nullptr) {
+		if (a != b && a != c && b != c) {
+			MaxPlusMul(a, b, c, next);
+			return;
+		}
 		constexpr int n = B;
-		for (int k = 0; k < n; k += 2) for (int i = 0; i < n; i += 4) {
-			vector_t coef00(b[(i + 0) * n + (k + 0)]);
-			vector_t coef01(b[(i + 0) * n + (k + 1)]);
-			vector_t coef10(b[(i + 1) * n + (k + 0)]);
-			vector_t coef11(b[(i + 1) * n + (k + 1)]);
-			vector_t coef20(b[(i + 2) * n + (k + 0)]);
-			vector_t coef21(b[(i + 2) * n + (k + 1)]);
-			vector_t coef30(b[(i + 3) * n + (k + 0)]);
-			vector_t coef31(b[(i + 3) * n + (k + 1)]);
+		for (int k = 0; k < n; k++) for (int i = 0; i < n; i++) {
+			vector_t coef(b[i * n + k]);
 			
 			T *aa = a + i * n;
 			T *bb = c + k * n;
-			for (int j = 0; j < n; j += vector_t::SIZE / sizeof(T)) {
-				vector_t t0(bb + j);
-				vector_t t1(bb + n + j);
-				max(t0 + coef00, t1 + coef01).chmax_store(aa + j);
-				max(t0 + coef10, t1 + coef11).chmax_store(aa + n + j);
-				max(t0 + coef20, t1 + coef21).chmax_store(aa + n + n + j);
-				max(t0 + coef30, t1 + coef31).chmax_store(aa + n + n + n + j);
-			}
+			for (int j = 0; j < n; j += vector_t::SIZE / sizeof(T))
+				extend(vector_t(bb + j), coef).chmax_store(aa + j);
 		}
 	}
-	static void MaxPlusMul3(T *a, T *b, T *c) {
+	/*
+		FWI_checked(a, b, c) : same as FWI(a, b, c) except that the updated elements of a are normalized:
+			elements not greater than -INF / 2 (i.e. unreachable) become -INF and the others are clamped to at most SATURATION
+		As long as the elements of b and c are normalized, no overflow happens even if the values diverge along negative cycles.
+		(for floating-point types, -INF / 2 is -infinity and SATURATION is finite so that infinity - infinity never happens)
+		a, b, c are distinct for most of the calls, where the normalization is done after the unrolled kernel
+		at the cost of O(B^2) instead of O(B^3)
+	*/
+	static void FWI_checked(T *a, T *b, T *c) {
+		vectorize::target_region<inst_set>::call([a, b, c] () { FWI_checked_kernel(a, b, c); });
+	}
+	static vector_t normalize(const vector_t &x) {
+		return vector_t::blend(greater(x, vector_t(-INF / 2)), min(x, vector_t(SATURATION)), vector_t(-INF));
+	}
+	static void FWI_checked_kernel(T *a, T *b, T *c) {
 		constexpr int n = B;
-		for (int k = 0; k < n; k += 4) for (int i = 0; i < n; i += 4) {
-			vector_t coef00(b[(i + 0) * n + (k + 0)]);
-			vector_t coef01(b[(i + 0) * n + (k + 1)]);
-			vector_t coef02(b[(i + 0) * n + (k + 2)]);
-			vector_t coef03(b[(i + 0) * n + (k + 3)]);
-			vector_t coef10(b[(i + 1) * n + (k + 0)]);
-			vector_t coef11(b[(i + 1) * n + (k + 1)]);
-			vector_t coef12(b[(i + 1) * n + (k + 2)]);
-			vector_t coef13(b[(i + 1) * n + (k + 3)]);
-			vector_t coef20(b[(i + 2) * n + (k + 0)]);
-			vector_t coef21(b[(i + 2) * n + (k + 1)]);
-			vector_t coef22(b[(i + 2) * n + (k + 2)]);
-			vector_t coef23(b[(i + 2) * n + (k + 3)]);
-			vector_t coef30(b[(i + 3) * n + (k + 0)]);
-			vector_t coef31(b[(i + 3) * n + (k + 1)]);
-			vector_t coef32(b[(i + 3) * n + (k + 2)]);
-			vector_t coef33(b[(i + 3) * n + (k + 3)]);
+		if (a != b && a != c && b != c) {
+			FWI_kernel(a, b, c);
+			for (int i = 0; i < n * n; i += vector_t::SIZE / sizeof(T)) normalize(vector_t(a + i)).store(a + i);
+			return;
+		}
+		for (int k = 0; k < n; k++) for (int i = 0; i < n; i++) {
+			vector_t coef(b[i * n + k]);
 			
 			T *aa = a + i * n;
 			T *bb = c + k * n;
-			for (int j = 0; j < n; j += vector_t::SIZE / sizeof(T)) {
-				vector_t t0(bb + j);
-				vector_t t1(bb + n + j);
-				vector_t t2(bb + n + n + j);
-				vector_t t3(bb + n + n + n + j);
-				max(max(t0 + coef00, t1 + coef01), max(t2 + coef02, t3 + coef03)).chmax_store(aa + j);
-				max(max(t0 + coef10, t1 + coef11), max(t2 + coef12, t3 + coef13)).chmax_store(aa + n + j);
-				max(max(t0 + coef20, t1 + coef21), max(t2 + coef22, t3 + coef23)).chmax_store(aa + n + n + j);
-				max(max(t0 + coef30, t1 + coef31), max(t2 + coef32, t3 + coef33)).chmax_store(aa + n + n + n + j);
-			}
+			for (int j = 0; j < n; j += vector_t::SIZE / sizeof(T))
+				normalize(max(vector_t(aa + j), vector_t(bb + j) + coef)).store(aa + j);
 		}
 	}
-	static void FWI(T *a, T *b, T *c) {
+	/*
+		FWI_path(a, b, c, a_next, b_next) : same as FWI(a, b, c) and
+			a_next[i * B + j] = b_next[i * B + k] if a[i * B + j] is updated by b[i * B + k] + c[k * B + j]
+		The update of a_next is done by blending with the comparison mask when index_t and T have the same size,
+		and only for the updated lanes otherwise.
+		a, b, c are distinct for most of the calls, which run the tiled kernel of MaxPlusMul in the path mode(see MaxPlusMulTile)
+	*/
+	template<typename index_t> static void FWI_path(T *a, T *b, T *c, index_t *a_next, index_t *b_next) {
+		vectorize::target_region<inst_set>::call([a, b, c, a_next, b_next] () { FWI_path_kernel(a, b, c, a_next, b_next); });
+	}
+	template<typename index_t> static void FWI_path_kernel(T *a, T *b, T *c, index_t *a_next, index_t *b_next) {
 		if (a != b && a != c && b != c) {
-			if (unroll_type == 0) MaxPlusMul0(a, b, c);
-			if (unroll_type == 1) MaxPlusMul1(a, b, c);
-			if (unroll_type == 2) MaxPlusMul2(a, b, c);
-			if (unroll_type == 3) MaxPlusMul3(a, b, c);
+			MaxPlusMulTile<TILE_ROWS, TILE_DEPTH>(a, b, c, nullptr, path_t<index_t>{ a_next, b_next });
 			return;
 		}
 		constexpr int n = B;
 		for (int k = 0; k < n; k++) for (int i = 0; i < n; i++) {
 			vector_t coef(b[i * n + k]);
+			index_t next = b_next[i * n + k];
 			
 			T *aa = a + i * n;
 			T *bb = c + k * n;
-			for (int j = 0; j < n; j += vector_t::SIZE / sizeof(T))
-				(vector_t(bb + j) + coef).chmax_store(aa + j);
+			index_t *aa_next = a_next + i * n;
+			for (int j = 0; j < n; j += vector_t::SIZE / sizeof(T)) {
+				vector_t cur(aa + j);
+				vector_t candidate = vector_t(bb + j) + coef;
+				typename vector_t::mask_t updated = greater(candidate, cur);
+				max(candidate, cur).store(aa + j);
+				update_next(updated, aa_next + j, next, std::integral_constant<bool, sizeof(index_t) == sizeof(T)>());
+			}
 		}
 	}
-	static void FWR(int n_blocks_power2, int n_blocks, int block_index0, int block_index1, int block_index2,
-		T **block_start, bool symmetric) {
+	template<typename index_t> static void update_next(const typename vector_t::mask_t &updated, index_t *ptr, index_t next, std::true_type) {
+		using index_vector_t = vectorize::vector_t<inst_set, index_t>;
+		index_vector_t::blend(updated, index_vector_t(next), index_vector_t(ptr)).store(ptr);
+	}
+	template<typename index_t> static void update_next(const typename vector_t::mask_t &updated, index_t *ptr, index_t next, std::false_type) {
+		for (uint64_t bits = vector_t::mask_to_bits(updated); bits; bits &= bits - 1) ptr[__builtin_ctzll(bits)] = next;
+	}
+	/*
+		Runs leaf(block_index0', block_index1', block_index2') for the BxB blocks in the recursive order(see recursion::FWR),
+		where leaf(i, k, j) is expected to do FWI on the blocks (i, j), (i, k), (k, j).
+		mask(if not null) is kept in sync when the blocks are copied to their transposed positions.
+		In the triangular layout, the calls writing blocks below the diagonal are skipped(see recursion::solve_triangular()).
+		If tracker is not null, the progress is reported at the start of each non-leaf call, and the recursion unwinds once cancelled
+	*/
+	template<typename Leaf> static void FWR(int n_blocks_power2, int n_blocks, int block_index0, int block_index1, int block_index2,
+		const blocks_t &blocks, bool symmetric, mask_t *mask, const Leaf &leaf, observe::tracker *tracker = nullptr) {
 		
-		if (block_index0 >= n_blocks || block_index1 >= n_blocks || block_index2 >= n_blocks) return;
-		if (n_blocks_power2 == 1) {
-			FWI(
-				block_start[block_index0 * n_blocks + block_index2],
-				block_start[block_index0 * n_blocks + block_index1],
-				block_start[block_index1 * n_blocks + block_index2]
-			);
+		recursion::FWR(n_blocks_power2, n_blocks, block_index0, block_index1, block_index2, blocks.is_triangular(), symmetric, leaf,
+			[n_blocks, &blocks, mask, tracker] (int n, int block_row_offset, int block_column_offset) {
+				transpose_copy(n, n_blocks, block_row_offset, block_column_offset, blocks, mask, tracker);
+			}, tracker);
+	}
+	/*
+		The number of the calls of leaf made by FWR(n_blocks_power2, n_blocks, block_index0, block_index1, block_index2, ...)
+		on blocks of the given layout, without running it.
+		The ranges of the indices are aligned to n_blocks_power2, so two of them are either the same or disjoint,
+		and the non-symmetric calls on ranges inside n_blocks are counted in O(1)
+	*/
+	static size_t count_leaves(int n_blocks_power2, int n_blocks, int block_index0, int block_index1, int block_index2, bool triangular, bool symmetric) {
+		if (block_index0 >= n_blocks || block_index1 >= n_blocks || block_index2 >= n_blocks) return 0;
+		if (triangular && block_index0 > block_index2) return 0;
+		const size_t p = n_blocks_power2;
+		if (!symmetric && std::max(block_index0, std::max(block_index1, block_index2)) + n_blocks_power2 <= n_blocks)
+			return !triangular || block_index0 != block_index2 ? p * p * p : p * p * (p + 1) / 2;
+		if (n_blocks_power2 == 1) return 1;
+		const int half = n_blocks_power2 >> 1;
+		size_t res = 0;
+		auto sub_call = [&] (int index0, int index1, int index2, bool sub_symmetric) {
+			res += count_leaves(half, n_blocks, index0, index1, index2, triangular, sub_symmetric);
+		};
+		if (!symmetric) {
+			for (int offset0 : { 0, half }) for (int offset1 : { 0, half }) for (int offset2 : { 0, half })
+				sub_call(block_index0 + offset0, block_index1 + offset1, block_index2 + offset2, false);
+		} else if (triangular) {
+			recursion::solve_triangular(half, block_index0, sub_call);
 		} else {
-			int half = n_blocks_power2 >> 1;
-			if (!symmetric) {
-				FWR(half, n_blocks, block_index0       , block_index1       , block_index2       , block_start, false);
-				FWR(half, n_blocks, block_index0       , block_index1       , block_index2 + half, block_start, false);
-				FWR(half, n_blocks, block_index0 + half, block_index1       , block_index2       , block_start, false);
-				FWR(half, n_blocks, block_index0 + half, block_index1       , block_index2 + half, block_start, false);
-				FWR(half, n_blocks, block_index0 + half, block_index1 + half, block_index2 + half, block_start, false);
-				FWR(half, n_blocks, block_index0 + half, block_index1 + half, block_index2       , block_start, false);
-				FWR(half, n_blocks, block_index0       , block_index1 + half, block_index2 + half, block_start, false);
-				FWR(half, n_blocks, block_index0       , block_index1 + half, block_index2       , block_start, false);
-			} else {
-				// if symmetric, block_index0 = block_index1 = block_index2
-				FWR(half, n_blocks, block_index0       , block_index1       , block_index2       , block_start, true);
-				FWR(half, n_blocks, block_index0       , block_index1       , block_index2 + half, block_start, false);
-				transpose_copy(half, n_blocks, block_index0, block_index0 + half, block_start);
-				FWR(half, n_blocks, block_index0 + half, block_index1       , block_index2 + half, block_start, false);
-				FWR(half, n_blocks, block_index0 + half, block_index1 + half, block_index2 + half, block_start, true);
-				FWR(half, n_blocks, block_index0 + half, block_index1 + half, block_index2       , block_start, false);
-				transpose_copy(half, n_blocks, block_index0 + half, block_index0, block_start);
-				FWR(half, n_blocks, block_index0       , block_index1 + half, block_index2       , block_start, false);
-			}
+			// the other two are done by transpose_copy()
+			const int x = block_index0, y = block_index0 + half;
+			sub_call(x, x, x, true);
+			sub_call(x, x, y, false);
+			sub_call(y, x, y, false);
+			sub_call(y, y, y, true);
+			sub_call(y, y, x, false);
+			sub_call(x, y, x, false);
 		}
+		return res;
+	}
+	/*
+		The block (i, j) as an operand of FWI.
+		In the triangular layout, the block (j, i) is transposed into the slot of a buffer of the calling thread if i > j,
+		which takes O(B^2) time against O(B^3) of FWI
+	*/
+	static T *operand(const blocks_t &blocks, int i, int j, int slot) {
+		if (!blocks.is_triangular() || i <= j) return blocks(i, j);
+		struct buffer_t {
+			void *buffer_org = nullptr;
+			T *head = allocate_aligned(2 * B * B, buffer_org);
+			~buffer_t () { free(buffer_org); }
+		};
+		static thread_local buffer_t buffer;
+		const T *src = blocks(j, i);
+		T *dst = buffer.head + slot * B * B;
+		for (int y = 0; y < B; y++) for (int x = 0; x < B; x++) dst[x * B + y] = src[y * B + x];
+		return dst;
 	}
 	// copy [block_row_offset:block_row_offset+n)[block_column_offset:block_column_offset+n) to its transposed posititon
 	// anything outside n_blocks * n_blocks blocks is ignored
-	static void transpose_copy(int n, int n_blocks, int block_row_offset, int block_column_offset, T **block_start) {
+	static void transpose_copy(int n, int n_blocks, int block_row_offset, int block_column_offset, const blocks_t &blocks, mask_t *mask,
+		observe::tracker *tracker = nullptr) {
+		
+		observe::stopwatch time;
 		for (int i = block_row_offset; i < block_row_offset + n && i < n_blocks; i++) 
 			for (int j = block_column_offset; j < block_column_offset + n && j < n_blocks; j++) {
 			
-			T *src = block_start[i * n_blocks + j];
-			T *dst = block_start[j * n_blocks + i];
+			T *src = blocks(i, j);
+			T *dst = blocks(j, i);
 			for (int y = 0; y < B; y++) for (int x = 0; x < B; x++) dst[x * B + y] = src[y * B + x];
+			if (mask) mask->set(j, i, mask->is_inf(i, j));
 		}
+		if (tracker) tracker->add_seconds(observe::phase_t::TRANSPOSE_COPY, time.seconds());
+	}
+	// whether every element of the block is INF
+	static bool is_inf_block(const T *block) {
+		for (int i = 0; i < B * B; i++) if (block[i] > encode(INF)) return false;
+		return true;
+	}
+	// sets mask to the flags of the all-INF blocks, reusing its memory
+	static void find_inf_blocks(int n_blocks, const blocks_t &blocks, mask_t &mask) {
+		mask.assign(n_blocks, blocks.is_triangular());
+		for (int i = 0; i < n_blocks; i++) for (int j = blocks.is_triangular() ? i : 0; j < n_blocks; j++)
+			mask.set(i, j, is_inf_block(blocks(i, j)));
+	}
+	static mask_t inf_blocks(int n_blocks, const blocks_t &blocks) {
+		mask_t mask;
+		find_inf_blocks(n_blocks, blocks, mask);
+		return mask;
 	}
 	/*
-		rev == false :
-			Copy the n * n elements in src to dst in the order like this(each src[i][j] is a BxB block):
-			dst: src[0][0], src[0][1], src[1][0], src[1][1],
-				 src[0][2], src[0][3], src[1][2], src[1][3],
-				 src[2][0], src[2][1], src[3][0], src[3][1],
-				 src[2][2], src[2][3], src[3][2], src[3][3],
-				 src[0][4], src[0][5], src[1][4], src[1][5], ...
-			and returns the pointer to the next element of the last element written in dst.
-			Elements outside the n_blocks * n_blocks blocks will be ignored
-			Elements in dst corresponding to elements outside the src_n * src_n but in n_blocks * n_blocks
-				will be filled
-			block_start[i * n_blocks + j] will point to the starting element in dst corresponding to (i, j) block
+		fwi(blocks (i, j), (i, k), (k, j)) unless (i, k) or (k, j) is all INF, in which case the call cannot change (i, j).
+		This skips most of the calls on the padding, and on the graphs whose vertices are grouped into clusters
+		(see run_sparse()), those between the clusters until they get connected.
+		Returns whether fwi was called
+	*/
+	template<typename Kernel> static bool FWI_sparse(int i, int k, int j, const blocks_t &blocks, mask_t &mask, const Kernel &fwi) {
+		if (mask.is_inf(i, k) || mask.is_inf(k, j)) return false;
+		T *a = blocks(i, j);
+		fwi(a, operand(blocks, i, k, 0), operand(blocks, k, j, 1));
+		if (mask.is_inf(i, j)) mask.set(i, j, is_inf_block(a));
+		return true;
+	}
+	// a weakly connected component: its vertices in the increasing order and the submatrix induced by them
+	struct component_t {
+		std::vector<int> vertices;
+		std::vector<T> matrix;
+	};
+	/*
+		Copies the submatrix of each weakly connected component into components, the largest first.
+		The components of a single vertex need no solving.
+		Returns false without copying anything if the whole graph is connected
+	*/
+	static bool split_components(int src_n, const T *input_matrix, std::vector<component_t> &components) {
+		std::vector<std::vector<int> > vertex_sets = sparsity::weakly_connected_components(src_n, input_matrix, (T) INF); // avoid referencing a constexpr variable
+		if (vertex_sets.size() <= 1) return false;
+		std::stable_sort(vertex_sets.begin(), vertex_sets.end(),
+			[] (const std::vector<int> &lhs, const std::vector<int> &rhs) { return lhs.size() > rhs.size(); });
+		components.clear();
+		for (auto &vertices : vertex_sets) {
+			const int n = vertices.size();
+			component_t component;
+			component.matrix.resize((size_t) n * n);
+			for (int i = 0; i < n; i++) for (int j = 0; j < n; j++)
+				component.matrix[(size_t) i * n + j] = input_matrix[(size_t) vertices[i] * src_n + vertices[j]];
+			component.vertices = std::move(vertices);
+			components.push_back(std::move(component));
+		}
+		return true;
+	}
+	// writes the solved components to output_matrix, with INF between different components
+	static void merge_components(int src_n, const std::vector<component_t> &components, T *output_matrix) {
+		std::fill(output_matrix, output_matrix + (size_t) src_n * src_n, (T) INF); // avoid referencing a constexpr variable
+		for (auto &component : components) {
+			const int n = component.vertices.size();
+			for (int i = 0; i < n; i++) for (int j = 0; j < n; j++)
+				output_matrix[(size_t) component.vertices[i] * src_n + component.vertices[j]] = component.matrix[(size_t) i * n + j];
+		}
+	}
+	// calls solve(n_blocks_power2, n_blocks, blocks) on the blocks of matrix
+	template<typename Solver> static void run_blocked(matrix_t &matrix, Solver solve) {
+		if (matrix.src_n) solve(matrix.n_blocks_power2, matrix.n_blocks, matrix.blocks);
+	}
+	/*
+		converts input_matrix into a blocked_matrix, calls run_blocked() and writes the result back to output_matrix.
+		If triangular, input_matrix must be symmetric and only the blocks on and above the diagonal are stored(see block_table).
+		The blocked_matrix is placed in workspace if not null
+	*/
+	template<typename Solver> static void run_reordered(int src_n, const T *input_matrix, T *output_matrix, Solver solve, bool triangular = false,
+		storage::workspace *workspace = nullptr) {
 		
-		rev == true :
-			same as rev == false except that the copy direction is reversed and
-				elements in dst where INF would be contained if !rev are untouched
+		matrix_t matrix(src_n, input_matrix, triangular, workspace, Semiring::raw);
+		run_blocked(matrix, solve);
+		matrix.to_matrix(output_matrix, Semiring::raw);
+	}
+	/*
+		Unless symmetric, each call of FWR is run when the next one is known, so that its blocks are prefetched while the current one runs.
+		Whether a call is skipped is still decided when it runs, in the same order.
+		(the symmetric mode runs the calls as they come, since the transpositions in between would have to wait for the pending call)
+	*/
+	static void solve(int n_blocks_power2, int n_blocks, const blocks_t &blocks, bool symmetric, mask_t &mask, observe::tracker *tracker) {
+		if (symmetric) {
+			FWR(n_blocks_power2, n_blocks, 0, 0, 0, blocks, true, &mask, [&blocks, &mask, tracker] (int i, int k, int j) {
+				bool executed = FWI_sparse(i, k, j, blocks, mask, FWI);
+				if (tracker) tracker->step(executed);
+			}, tracker);
+			return;
+		}
+		std::array<int, 3> pending = {{ -1, -1, -1 }};
+		auto run_pending = [&blocks, &mask, &pending, tracker] (const prefetch_t *next) {
+			if (pending[0] < 0) return;
+			bool executed = FWI_sparse(pending[0], pending[1], pending[2], blocks, mask, [next] (T *a, T *b, T *c) {
+				FWI_prefetching(a, b, c, next);
+			});
+			if (tracker) tracker->step(executed);
+		};
+		FWR(n_blocks_power2, n_blocks, 0, 0, 0, blocks, false, &mask, [&] (int i, int k, int j) {
+			// the call is most likely skipped if it would be skipped now
+			const bool skipped = mask.is_inf(i, k) || mask.is_inf(k, j);
+			const prefetch_t next = {{ blocks(i, j), blocks(i, k), blocks(k, j) }};
+			run_pending(skipped ? nullptr : &next);
+			pending = {{ i, k, j }};
+		}, tracker);
+		run_pending(nullptr);
+	}
+	static void solve(int n_blocks_power2, int n_blocks, const blocks_t &blocks, bool symmetric) {
+		mask_t mask = inf_blocks(n_blocks, blocks);
+		solve(n_blocks_power2, n_blocks, blocks, symmetric, mask, nullptr);
+	}
+	static void report(observe::observer &observer, observe::phase_t phase, double seconds) {
+		observer.stats.seconds[(int) phase] = seconds;
+		observer.on_phase(phase, seconds);
+	}
+	/*
+		Solves matrix with solve(n_blocks_power2, n_blocks, blocks, symmetric, mask, tracker) measured into observer(see observe::observer).
+		reorder_time is the time since the start of the conversion into matrix, if any.
+		Returns false if the observer is cancelled, in which case matrix is left partially solved
+	*/
+	template<typename Solver> static bool run_observed(matrix_t &matrix, bool symmetric, observe::observer &observer,
+		const observe::stopwatch &reorder_time, Solver solve) {
 		
-		This function negates all the element and FWR handles everything with max instead of min.
-		This is because chmax(mem, reg) can be implemented faster than chmin(mem, reg) with avx2+int64_t
-		The cost of negation should be negligible for other combinations, where this trick is irrelevant
+		observer.stats = observe::stats_t();
+		const int n_blocks = matrix.n_blocks;
+		mask_t mask = inf_blocks(n_blocks, matrix.blocks);
+		report(observer, observe::phase_t::REORDER, reorder_time.seconds());
+		if (!observer.cancelled() && matrix.src_n) {
+			observe::tracker tracker(observer, count_leaves(matrix.n_blocks_power2, n_blocks, 0, 0, 0, matrix.blocks.is_triangular(), symmetric));
+			observe::hardware_counters counters;
+			observe::stopwatch solve_time;
+			counters.start();
+			solve(matrix.n_blocks_power2, n_blocks, matrix.blocks, symmetric, mask, &tracker);
+			observer.stats.counters = counters.stop();
+			tracker.finish();
+			double transpose_copy_seconds = observer.stats.get_seconds(observe::phase_t::TRANSPOSE_COPY);
+			if (transpose_copy_seconds > 0) observer.on_phase(observe::phase_t::TRANSPOSE_COPY, transpose_copy_seconds);
+			report(observer, observe::phase_t::SOLVE, solve_time.seconds());
+		}
+		observer.stats.cancelled = observer.cancelled();
+		return !observer.stats.cancelled;
+	}
+	// run_observed() on input_matrix converted into a blocked_matrix, writing the result to output_matrix unless cancelled
+	template<typename Solver> static bool run_observed(int src_n, const T *input_matrix, T *output_matrix, bool symmetric,
+		observe::observer &observer, Solver solve) {
+		
+		observe::stopwatch reorder_time;
+		matrix_t matrix(src_n, input_matrix, symmetric, nullptr, Semiring::raw);
+		if (!run_observed(matrix, symmetric, observer, reorder_time, solve)) return false;
+		observe::stopwatch reorder_back_time;
+		matrix.to_matrix(output_matrix, Semiring::raw);
+		report(observer, observe::phase_t::REORDER_BACK, reorder_back_time.seconds());
+		return true;
+	}
+	/*
+		Makes the chains of next hops in next_matrix(src_n * src_n, written from the solved blocks) loop-free.
+		A next hop is only replaced when the distance strictly improves, but in the order of FWR rather than the k-i-j order,
+		so next[i][j] = next[i][k] may be taken while next[i][k] is not final yet.
+		Every next hop s of i for j still lies on a shortest path with the final distances D:
+		D(i, j) = w(i, s) + D(s, j)(0 instead of D(j, j) for s = j), so a chain that loops goes around a cycle of weight 0.
+		For each j, the chains are followed once to find the vertices leading into such a cycle,
+		and those vertices take new next hops one by one, each to a vertex whose chain already reaches j,
+		choosing the vertex and the next hop with the least w(i, s) + D(s, j) - D(i, j)(0 except for the rounding errors of the floating-point types).
+		Takes O(src_n^2), plus O(c * src_n) for each j with c vertices leading into cycles
 	*/
-	static T *reorder(int src_n, int n_blocks_power2, T *dst_head, T *src, T **block_start,
-		int block_row, int block_column, bool rev) {
+	template<typename index_t> static void break_next_cycles(int src_n, const T *input_matrix, const blocks_t &blocks, index_t *next_matrix) {
+		enum state_t : char { UNVISITED, ON_CHAIN, RESOLVED, LOOPING };
+		std::vector<state_t> state(src_n);
+		std::vector<int> chain, looping, best_next(src_n);
+		std::vector<long double> dist(src_n), best(src_n);
+		for (int j = 0; j < src_n; j++) {
+			auto next = [&] (int i) -> index_t & { return next_matrix[(size_t) i * src_n + j]; };
+			std::fill(state.begin(), state.end(), UNVISITED);
+			looping.clear();
+			for (int i = 0; i < src_n; i++) {
+				chain.clear();
+				state_t result;
+				for (int u = i; ; u = next(u)) {
+					if (state[u] != UNVISITED) {
+						result = state[u] == ON_CHAIN ? LOOPING : state[u];
+						break;
+					}
+					state[u] = ON_CHAIN;
+					chain.push_back(u);
+					if (u == j || next(u) < 0) {
+						result = RESOLVED;
+						break;
+					}
+				}
+				for (int u : chain) state[u] = result;
+				if (result == LOOPING) looping.insert(looping.end(), chain.begin(), chain.end());
+			}
+			if (looping.empty()) continue;
+			
+			for (int u = 0; u < src_n; u++) dist[u] = u == j ? 0 : encode(blocks(u / B, j / B)[(u % B) * B + j % B]);
+			// the resolved vertices with a next hop reach j
+			auto relax = [&] (int u, int s) {
+				const T weight = input_matrix[(size_t) u * src_n + s];
+				if (weight < INF && weight + dist[s] < best[u]) best[u] = weight + dist[s], best_next[u] = s;
+			};
+			for (int u : looping) {
+				best[u] = std::numeric_limits<long double>::infinity();
+				best_next[u] = -1;
+				for (int s = 0; s < src_n; s++) if (state[s] == RESOLVED && next(s) >= 0) relax(u, s);
+			}
+			for (size_t fixed = 0; fixed < looping.size(); fixed++) {
+				size_t chosen = fixed;
+				for (size_t t = fixed + 1; t < looping.size(); t++)
+					if (best[looping[t]] - dist[looping[t]] < best[looping[chosen]] - dist[looping[chosen]]) chosen = t;
+				std::swap(looping[fixed], looping[chosen]);
+				const int u = looping[fixed];
+				assert(best_next[u] >= 0); // u reaches j, so the last vertex on its shortest path not fixed yet has a candidate
+				next(u) = best_next[u];
+				for (size_t t = fixed + 1; t < looping.size(); t++) relax(looping[t], u);
+			}
+		}
+	}
+public:
+	static void run(int src_n, const T *input_matrix, T *output_matrix, bool symmetric = false) {
+		run_reordered(src_n, input_matrix, output_matrix, [symmetric] (int n_blocks_power2, int n_blocks, const blocks_t &blocks) {
+			solve(n_blocks_power2, n_blocks, blocks, symmetric);
+		}, symmetric);
+	}
+	// same as run(src_n, input_matrix, output_matrix, symmetric) but solves matrix in place without changing the layout
+	static void run(blocked_matrix<T, block_size> &matrix, bool symmetric = false) {
+		static_assert(!Semiring::raw, "blocked_matrix holds the encoded values");
+		run_blocked(matrix, [symmetric] (int n_blocks_power2, int n_blocks, const blocks_t &blocks) {
+			solve(n_blocks_power2, n_blocks, blocks, symmetric);
+		});
+	}
+	/*
+		Same as run(src_n, input_matrix, output_matrix, symmetric), but reports to observer(see observe::observer)
+		the time of each phase, the numbers of FWI calls executed and skipped, the hardware counters during the solve(if available),
+		and the progress at the boundaries of the recursion, where observer.cancel() is also checked.
+		Returns false without writing output_matrix if cancelled. The measurements cost nothing measurable against the solve
+	*/
+	static bool run(int src_n, const T *input_matrix, T *output_matrix, bool symmetric, observe::observer &observer) {
+		return run_observed(src_n, input_matrix, output_matrix, symmetric, observer, [] (int n_blocks_power2, int n_blocks,
+			const blocks_t &blocks, bool symmetric, mask_t &mask, observe::tracker *tracker) {
+			solve(n_blocks_power2, n_blocks, blocks, symmetric, mask, tracker);
+		});
+	}
+	// same as run(matrix, symmetric) with observer, leaving matrix partially solved if cancelled
+	static bool run(blocked_matrix<T, block_size> &matrix, bool symmetric, observe::observer &observer) {
+		static_assert(!Semiring::raw, "blocked_matrix holds the encoded values");
+		return run_observed(matrix, symmetric, observer, observe::stopwatch(), [] (int n_blocks_power2, int n_blocks,
+			const blocks_t &blocks, bool symmetric, mask_t &mask, observe::tracker *tracker) {
+			solve(n_blocks_power2, n_blocks, blocks, symmetric, mask, tracker);
+		});
+	}
+	/*
+		Same as run(src_n, input_matrix, output_matrix, symmetric), but solves the graph with the vertices renumbered
+		in the reverse Cuthill-McKee order(see sparsity::reverse_cuthill_mckee), which keeps the edges near the diagonal
+		and each connected component in a contiguous range, so that more blocks stay all INF and more FWI calls are skipped.
+		Worth it for sparse clustered graphs(e.g. road networks) whose vertices are not numbered by locality.
+		Takes O(src_n^2) extra time and memory
+	*/
+	static void run_sparse(int src_n, const T *input_matrix, T *output_matrix, bool symmetric = false) {
+		static_assert(!Semiring::raw, "no edge must be INF");
+		const std::vector<int> order = sparsity::reverse_cuthill_mckee(src_n, input_matrix, INF);
+		std::vector<T> permuted((size_t) src_n * src_n);
+		for (int i = 0; i < src_n; i++) for (int j = 0; j < src_n; j++)
+			permuted[(size_t) i * src_n + j] = input_matrix[(size_t) order[i] * src_n + order[j]];
+		run(src_n, permuted.data(), permuted.data(), symmetric);
+		for (int i = 0; i < src_n; i++) for (int j = 0; j < src_n; j++)
+			output_matrix[(size_t) order[i] * src_n + order[j]] = permuted[(size_t) i * src_n + j];
+	}
+	/*
+		Same as run(src_n, input_matrix, output_matrix, symmetric), but solves each weakly connected component of the graph
+		as an independent graph(see sparsity::weakly_connected_components), which takes the sum of the cubes of their sizes
+		instead of the cube of src_n. Finding them takes O(src_n^2) time and the components take O(src_n^2) extra memory in total
+	*/
+	static void run_components(int src_n, const T *input_matrix, T *output_matrix, bool symmetric = false) {
+		static_assert(!Semiring::raw, "no edge must be INF");
+		std::vector<component_t> components;
+		if (!split_components(src_n, input_matrix, components)) {
+			run(src_n, input_matrix, output_matrix, symmetric);
+			return;
+		}
+		for (auto &component : components) if (component.vertices.size() > 1)
+			run(component.vertices.size(), component.matrix.data(), component.matrix.data(), symmetric);
+		merge_components(src_n, components, output_matrix);
+	}
+	/*
+		Same as run(src_n, input_matrix, output_matrix) and also writes the next-hop matrix to next_matrix:
+		next_matrix[i * src_n + j] is the vertex next to i on a shortest path from i to j, or -1 if j is unreachable from i.
+		The paths can be restored with get_path(), and they never loop even if the graph has cycles of weight 0(see break_next_cycles())
+	*/
+	template<typename index_t> static void run(int src_n, const T *input_matrix, T *output_matrix, index_t *next_matrix) {
+		static_assert(std::is_same<index_t, int16_t>::value || std::is_same<index_t, int32_t>::value, "index_t must be int16_t or int32_t");
+		static_assert(is_min_plus, "only for the shortest paths");
+		assert(src_n - 1 <= std::numeric_limits<index_t>::max());
+		void *next_reordered_org = nullptr;
+		run_reordered(src_n, input_matrix, output_matrix, [&] (int n_blocks_power2, int n_blocks, const blocks_t &blocks) {
+			// the blocks of next_matrix are placed at the same offsets as those of the distance matrix
+			index_t *next_reordered = allocate_aligned<index_t>((size_t) (B * n_blocks) * (B * n_blocks), next_reordered_org);
+			T *reordered = blocks.data();
+			auto next_block = [&] (int i, int j) { return next_reordered + (blocks(i, j) - reordered); };
+			
+			for (int i = 0; i < n_blocks; i++) for (int j = 0; j < n_blocks; j++) {
+				T *dist = blocks(i, j);
+				index_t *next = next_block(i, j);
+				for (int y = 0; y < B; y++) for (int x = 0; x < B; x++)
+					next[y * B + x] = dist[y * B + x] > encode(INF) ? j * B + x : -1;
+			}
+			// the calls on an all-INF block (i, k) or (k, j) are skipped as in solve(), since they update neither matrix
+			mask_t mask = inf_blocks(n_blocks, blocks);
+			FWR(n_blocks_power2, n_blocks, 0, 0, 0, blocks, false, nullptr, [&] (int i, int k, int j) {
+				FWI_sparse(i, k, j, blocks, mask, [&] (T *a, T *b, T *c) {
+					FWI_path(a, b, c, next_reordered + (a - reordered), next_reordered + (b - reordered));
+				});
+			});
+			
+			for (int i = 0; i < n_blocks; i++) for (int j = 0; j < n_blocks; j++) {
+				const index_t *next = next_block(i, j);
+				for (int y = 0; y < B && i * B + y < src_n; y++) for (int x = 0; x < B && j * B + x < src_n; x++)
+					next_matrix[(size_t) (i * B + y) * src_n + j * B + x] = next[y * B + x];
+			}
+			break_next_cycles(src_n, input_matrix, blocks, next_matrix);
+		});
+		free(next_reordered_org);
+	}
+	/*
+		Same as run(src_n, input_matrix, output_matrix) except that the graph may contain negative cycles:
+		 - output_matrix[i * src_n + j] is -INF if a walk from i to j can be made arbitrarily short by going around a negative cycle
+		 - reaches_negative_cycle[i] (if not null) is set to whether vertex i lies on or reaches a negative cycle
+		 - returns true if the graph contains a negative cycle
+		Any path in the input graph must have a total weight with absolute value less than SATURATION instead of INF.
+		The distances are saturated in FWI_checked, and the affected pairs are found from the diagonal after FWR
+	*/
+	static bool run_checked(int src_n, const T *input_matrix, T *output_matrix, bool *reaches_negative_cycle = nullptr) {
+		static_assert(!std::is_unsigned<T>::value, "unsigned types cannot have negative weights");
+		static_assert(is_min_plus, "only for the shortest paths");
+		run_reordered(src_n, input_matrix, output_matrix, [] (int n_blocks_power2, int n_blocks, const blocks_t &blocks) {
+			mask_t mask = inf_blocks(n_blocks, blocks);
+			FWR(n_blocks_power2, n_blocks, 0, 0, 0, blocks, false, nullptr, [&blocks, &mask] (int i, int k, int j) {
+				FWI_sparse(i, k, j, blocks, mask, FWI_checked);
+			});
+		});
+		return negative_cycle::propagate<T>(src_n, output_matrix, INF, reaches_negative_cycle);
+	}
+private:
+	// the number of graphs solved together by run_batch(), one in each lane of vector_t
+	static constexpr int BATCH_LANES = vector_t::SIZE / sizeof(T);
+	static constexpr size_t BATCH_CHUNK = 64;
+	/*
+		run_batch() solves larger graphs one by one with run():
+		FW_batch_kernel streams all the n * n vectors at each step, which falls out of L1 around this size
+		and becomes slower than the blocked kernels at n = 56 for int32_t with AVX2 and AVX-512
+	*/
+	static constexpr int BATCH_MAX_N = 48;
+	static void FW_batch(int n, T *a) {
+		vectorize::target_region<inst_set>::call([n, a] () { FW_batch_kernel(n, a); });
+	}
+	/*
+		a : n * n vectors(BATCH_LANES elements each), where lane l of vector i * n + j is the element (i, j) of the l-th graph
+		Each step of the textbook Floyd-Warshall algorithm is done for all the lanes at once.
+		Row k is not changed in step k since the distance from k to itself is not negative in any lane
+		(there is no negative cycle, and the unused lanes filled with encode(INF) never increase), so the rows can be updated in place
+	*/
+	static void FW_batch_kernel(int n, T *a) {
+		constexpr int L = BATCH_LANES;
+		const size_t row_size = (size_t) n * L;
+		for (int k = 0; k < n; k++) {
+			T *row_k = a + k * row_size;
+			int i = 0;
+			for (; i + 4 <= n; i += 4) {
+				T *row0 = a + i * row_size;
+				T *row1 = row0 + row_size;
+				T *row2 = row1 + row_size;
+				T *row3 = row2 + row_size;
+				vector_t coef0(row0 + k * L);
+				vector_t coef1(row1 + k * L);
+				vector_t coef2(row2 + k * L);
+				vector_t coef3(row3 + k * L);
+				for (size_t j = 0; j < row_size; j += L) {
+					vector_t t(row_k + j);
+					(t + coef0).chmax_store(row0 + j);
+					(t + coef1).chmax_store(row1 + j);
+					(t + coef2).chmax_store(row2 + j);
+					(t + coef3).chmax_store(row3 + j);
+				}
+			}
+			for (; i < n; i++) {
+				T *row0 = a + i * row_size;
+				vector_t coef0(row0 + k * L);
+				for (size_t j = 0; j < row_size; j += L) (vector_t(row_k + j) + coef0).chmax_store(row0 + j);
+			}
+		}
+	}
+public:
+	/*
+		Solves count independent graphs with n vertices each, the g-th one given as input_matrices[g * n * n + i * n + j]
+		(same format as input_matrix of run()) and written to output_matrices in the same way.
+		output_matrices may be the same as input_matrices.
+		For small n(up to BATCH_MAX_N), where run() would spend most of its time on the allocation, the reordering,
+		and the padding to block_size, the graphs are interleaved so that each lane of a vector holds a different graph
+		and the textbook algorithm runs on all of them at once without any padding.
+		Takes O(count * n^3 / lanes) time and O(n^2 * lanes) extra memory
+	*/
+	static void run_batch(int count, int n, const T *input_matrices, T *output_matrices) {
+		static_assert(is_min_plus, "only for the shortest paths");
+		constexpr int L = BATCH_LANES;
+		if (count <= 0 || n <= 0) return;
+		const size_t n_elements = (size_t) n * n;
+		if (n > BATCH_MAX_N) {
+			for (int g = 0; g < count; g++) run(n, input_matrices + g * n_elements, output_matrices + g * n_elements);
+			return;
+		}
+		void *buffer_org;
+		T *interleaved = allocate_aligned(n_elements * L, buffer_org);
+
+		for (int first = 0; first < count; first += L) {
+			const int n_graphs = std::min(L, count - first);
+			const T *input = input_matrices + first * n_elements;
+			T *output = output_matrices + first * n_elements;
+			// transposed in chunks of BATCH_CHUNK elements, so that both sides are accessed sequentially within a chunk
+			// the unused lanes are filled with encode(INF), which never affects the other lanes
+			for (size_t chunk = 0; chunk < n_elements; chunk += BATCH_CHUNK) {
+				const size_t chunk_end = std::min(n_elements, chunk + BATCH_CHUNK);
+				for (int l = 0; l < L; l++) for (size_t e = chunk; e < chunk_end; e++)
+					interleaved[e * L + l] = encode(l < n_graphs ? input[l * n_elements + e] : INF);
+			}
+			FW_batch(n, interleaved);
+			for (size_t chunk = 0; chunk < n_elements; chunk += BATCH_CHUNK) {
+				const size_t chunk_end = std::min(n_elements, chunk + BATCH_CHUNK);
+				for (int l = 0; l < n_graphs; l++) for (size_t e = chunk; e < chunk_end; e++)
+					output[l * n_elements + e] = encode(interleaved[e * L + l]);
+			}
+		}
+		free(buffer_org);
+	}
+private:
+	// encodes the n_rows * n_columns row-major matrix src into BxB blocks stored row by row(not in the Z-order),
+	// with the padding filled with encode(INF)
+	static void pack(int n_rows, int n_columns, const T *src, T *dst) {
+		const int n_block_rows = (n_rows + B - 1) / B, n_block_columns = (n_columns + B - 1) / B;
+		for (int block_row = 0; block_row < n_block_rows; block_row++) for (int block_column = 0; block_column < n_block_columns; block_column++) {
+			T *block = dst + ((size_t) block_row * n_block_columns + block_column) * B * B;
+			for (int y = 0; y < B; y++) {
+				const int i = block_row * B + y;
+				const int length = i < n_rows ? std::min(B, n_columns - block_column * B) : 0;
+				for (int x = 0; x < length; x++) block[y * B + x] = encode(src[(size_t) i * n_columns + block_column * B + x]);
+				for (int x = length; x < B; x++) block[y * B + x] = encode(INF);
+			}
+		}
+	}
+	// the inverse of pack() for the elements inside n_rows * n_columns
+	static void unpack(int n_rows, int n_columns, const T *src, T *dst) {
+		const int n_block_rows = (n_rows + B - 1) / B, n_block_columns = (n_columns + B - 1) / B;
+		for (int block_row = 0; block_row < n_block_rows; block_row++) for (int block_column = 0; block_column < n_block_columns; block_column++) {
+			const T *block = src + ((size_t) block_row * n_block_columns + block_column) * B * B;
+			const int length = std::min(B, n_columns - block_column * B);
+			for (int y = 0; y < B && block_row * B + y < n_rows; y++)
+				for (int x = 0; x < length; x++) dst[(size_t) (block_row * B + y) * n_columns + block_column * B + x] = encode(block[y * B + x]);
+		}
+	}
+	// 64-byte aligned buffer for n_elements elements of U; buffer_org is to be freed
+	template<typename U = T> static U *allocate_aligned(size_t n_elements, void *&buffer_org) {
+		const size_t needed_size = n_elements * sizeof(U);
+		size_t buffer_size = needed_size + 64;
+		buffer_org = malloc(buffer_size);
+		assert(buffer_org);
+		void *buffer = buffer_org;
+		U *aligned = (U *) std::align(64, needed_size, buffer, buffer_size);
+		assert(aligned);
+		return aligned;
+	}
+public:
+	/*
+		Min-plus(tropical) matrix product accumulated into c:
+			c[i * n + j] = min(c[i * n + j], min{a[i * k + l] + b[l * n + j] | l in [0, k)}) for all i in [0, m), j in [0, n)
+		a, b, c : m * k, k * n, m * n row-major matrices; c must not overlap with a or b.
+		Fill c with INF beforehand to get the product itself.
+		The matrices are packed into BxB blocks(encoded and padded with INF like the blocked layout of run())
+		and each triple of blocks is multiplied with MaxPlusMul, looping over l innermost so that the block of c stays in the cache.
+		INF is an ordinary large value in the sums, so the same constraints as the input of run() apply
+		to the elements of a and b as the weights of the paths of two edges
+	*/
+	static void min_plus_multiply(int m, int n, int k, const T *a, const T *b, T *c) {
+		static_assert(is_min_plus, "only for the shortest paths");
+		if (m <= 0 || n <= 0 || k <= 0) return;
+		const int m_blocks = (m + B - 1) / B, n_blocks = (n + B - 1) / B, k_blocks = (k + B - 1) / B;
+		void *a_org, *b_org, *c_org;
+		T *a_packed = allocate_aligned((size_t) m_blocks * k_blocks * B * B, a_org);
+		T *b_packed = allocate_aligned((size_t) k_blocks * n_blocks * B * B, b_org);
+		T *c_packed = allocate_aligned((size_t) m_blocks * n_blocks * B * B, c_org);
+		pack(m, k, a, a_packed);
+		pack(k, n, b, b_packed);
+		pack(m, n, c, c_packed);
+		vectorize::target_region<inst_set>::call([=] () {
+			for (int i = 0; i < m_blocks; i++) for (int j = 0; j < n_blocks; j++) {
+				T *c_block = c_packed + ((size_t) i * n_blocks + j) * B * B;
+				for (int l = 0; l < k_blocks; l++)
+					MaxPlusMul(c_block, a_packed + ((size_t) i * k_blocks + l) * B * B, b_packed + ((size_t) l * n_blocks + j) * B * B);
+			}
+		});
+		unpack(m, n, c_packed, c);
+		free(a_org);
+		free(b_org);
+		free(c_org);
+	}
+};
+
+/*
+	the vertices on the shortest path from u to v(both inclusive) restored from next_matrix written by floyd_warshall::run
+	empty if v is unreachable from u, or if the chain from u does not reach v in n steps(never the case with floyd_warshall::run)
+*/
+template<typename index_t> std::vector<int> get_path(int n, const index_t *next_matrix, int u, int v) {
+	std::vector<int> path;
+	if (next_matrix[(size_t) u * n + v] < 0) return path;
+	path.push_back(u);
+	while (u != v) {
+		if ((int) path.size() > n) return std::vector<int>();
+		u = next_matrix[(size_t) u * n + v];
+		path.push_back(u);
+	}
+	return path;
+}
+
+/*
+	Multithreaded version of floyd_warshall
+	Each recursion step of FWR is split into its sub-calls, and a sub-call is made to wait only for the preceding
+	sub-calls that write a block it reads or writes, or read a block it writes.
+	Sub-calls with no such dependency between them run concurrently on a work-stealing thread pool.
+	The result is bit-identical to that of floyd_warshall<inst_set, T, unroll_type, block_size>
+*/
+template<InstSet inst_set, typename T, int unroll_type, int block_size = 64> struct parallel_floyd_warshall {
+private:
+	using base = floyd_warshall<inst_set, T, unroll_type, block_size>;
+	using blocks_t = typename base::blocks_t;
+	using mask_t = typename base::mask_t;
+public:
+	static constexpr T INF = base::INF;
+	using value_t = T;
+	
+	static std::string get_description() { return "parallel_" + base::get_description(); }
+private:
+	// FWR(block_index0, block_index1, block_index2) writes block (0, 2) and reads blocks (0, 1), (1, 2)
+	struct sub_call_t { int block_index0, block_index1, block_index2; };
+	static bool conflicts(const sub_call_t &lhs, const sub_call_t &rhs) {
+		auto writes = [] (const sub_call_t &call, int row, int column) {
+			return call.block_index0 == row && call.block_index2 == column;
+		};
+		auto reads_or_writes = [&] (const sub_call_t &call, int row, int column) {
+			return writes(call, row, column) ||
+				(call.block_index0 == row && call.block_index1 == column) ||
+				(call.block_index1 == row && call.block_index2 == column);
+		};
+		return reads_or_writes(rhs, lhs.block_index0, lhs.block_index2) || reads_or_writes(lhs, rhs.block_index0, rhs.block_index2);
+	}
+	// the flags of mask are bytes, so that the sub-calls running concurrently write different ones
+	static void FWR(parallel::thread_pool &pool, int n_blocks_power2, int n_blocks, int block_index0, int block_index1, int block_index2,
+		const blocks_t &blocks, bool symmetric, mask_t &mask, observe::tracker *tracker = nullptr) {
 		
-		int n_blocks = (src_n + B - 1) / B;
-		if (block_row >= n_blocks || block_column >= n_blocks) return dst_head;
+		if (block_index0 >= n_blocks || block_index1 >= n_blocks || block_index2 >= n_blocks) return;
+		if (blocks.is_triangular() && block_index0 > block_index2) return;
 		if (n_blocks_power2 == 1) {
-			T *src_base = src + (block_row * B * src_n + block_column * B);
-			for (int i = 0; i < B; i++) {
-				if (block_row * B + i < src_n) {
-					int length = std::min(B, src_n - block_column * B);
-					if (!rev) {
-						for (int j = 0; j < length; j++) dst_head[i * B + j] = -src_base[i * src_n + j];
-						for (int j = length; j < B; j++) dst_head[i * B + j] = -INF;
-					} else {
-						for (int j = 0; j < length; j++) src_base[i * src_n + j] = -dst_head[i * B + j];
+			bool executed = base::FWI_sparse(block_index0, block_index1, block_index2, blocks, mask, base::FWI);
+			if (tracker) tracker->step(executed);
+			return;
+		}
+		if (tracker && !tracker->check()) return;
+		int half = n_blocks_power2 >> 1;
+		if (symmetric && blocks.is_triangular()) {
+			recursion::solve_triangular(half, block_index0, [&] (int index0, int index1, int index2, bool sub_symmetric) {
+				FWR(pool, half, n_blocks, index0, index1, index2, blocks, sub_symmetric, mask, tracker);
+			});
+			return;
+		}
+		if (symmetric) {
+			// the sub-calls here depend on each other in a chain; parallelism comes from the non-symmetric ones
+			FWR(pool, half, n_blocks, block_index0       , block_index1       , block_index2       , blocks, true, mask, tracker);
+			FWR(pool, half, n_blocks, block_index0       , block_index1       , block_index2 + half, blocks, false, mask, tracker);
+			base::transpose_copy(half, n_blocks, block_index0, block_index0 + half, blocks, &mask, tracker);
+			FWR(pool, half, n_blocks, block_index0 + half, block_index1       , block_index2 + half, blocks, false, mask, tracker);
+			FWR(pool, half, n_blocks, block_index0 + half, block_index1 + half, block_index2 + half, blocks, true, mask, tracker);
+			FWR(pool, half, n_blocks, block_index0 + half, block_index1 + half, block_index2       , blocks, false, mask, tracker);
+			base::transpose_copy(half, n_blocks, block_index0 + half, block_index0, blocks, &mask, tracker);
+			FWR(pool, half, n_blocks, block_index0       , block_index1 + half, block_index2       , blocks, false, mask, tracker);
+			return;
+		}
+		const sub_call_t calls[8] = {
+			{ block_index0       , block_index1       , block_index2        },
+			{ block_index0       , block_index1       , block_index2 + half },
+			{ block_index0 + half, block_index1       , block_index2        },
+			{ block_index0 + half, block_index1       , block_index2 + half },
+			{ block_index0 + half, block_index1 + half, block_index2 + half },
+			{ block_index0 + half, block_index1 + half, block_index2        },
+			{ block_index0       , block_index1 + half, block_index2 + half },
+			{ block_index0       , block_index1 + half, block_index2        }
+		};
+		// level[i] : 1 + the maximum level among the preceding sub-calls that sub-call i depends on
+		// sub-calls with the same level are independent of each other
+		int level[8];
+		int n_levels = 0;
+		for (int i = 0; i < 8; i++) {
+			if (calls[i].block_index0 >= n_blocks || calls[i].block_index1 >= n_blocks || calls[i].block_index2 >= n_blocks ||
+				(blocks.is_triangular() && calls[i].block_index0 > calls[i].block_index2)) {
+				level[i] = -1;
+				continue;
+			}
+			level[i] = 0;
+			for (int j = 0; j < i; j++) if (level[j] >= 0 && conflicts(calls[j], calls[i]))
+				level[i] = std::max(level[i], level[j] + 1);
+			n_levels = std::max(n_levels, level[i] + 1);
+		}
+		for (int l = 0; l < n_levels; l++) {
+			std::function<void()> tasks[8];
+			int n_tasks = 0;
+			for (int i = 0; i < 8; i++) if (level[i] == l) {
+				const sub_call_t &call = calls[i];
+				tasks[n_tasks++] = [&pool, half, n_blocks, call, &blocks, &mask, tracker] () {
+					FWR(pool, half, n_blocks, call.block_index0, call.block_index1, call.block_index2, blocks, false, mask, tracker);
+				};
+			}
+			pool.run_all(tasks, n_tasks);
+		}
+	}
+	static void solve(parallel::thread_pool &pool, int n_blocks_power2, int n_blocks, const blocks_t &blocks, bool symmetric) {
+		mask_t mask = base::inf_blocks(n_blocks, blocks);
+		FWR(pool, n_blocks_power2, n_blocks, 0, 0, 0, blocks, symmetric, mask);
+	}
+public:
+	// n_threads <= 0 : use all the hardware threads
+	static void run(int src_n, const T *input_matrix, T *output_matrix, bool symmetric = false, int n_threads = 0) {
+		parallel::thread_pool pool(n_threads);
+		base::run_reordered(src_n, input_matrix, output_matrix, [&] (int n_blocks_power2, int n_blocks, const blocks_t &blocks) {
+			solve(pool, n_blocks_power2, n_blocks, blocks, symmetric);
+		}, symmetric);
+	}
+	// solves matrix in place like floyd_warshall::run(matrix, symmetric)
+	static void run(blocked_matrix<T, block_size> &matrix, bool symmetric = false, int n_threads = 0) {
+		parallel::thread_pool pool(n_threads);
+		base::run_blocked(matrix, [&] (int n_blocks_power2, int n_blocks, const blocks_t &blocks) {
+			solve(pool, n_blocks_power2, n_blocks, blocks, symmetric);
+		});
+	}
+	/*
+		Same as floyd_warshall::run(src_n, input_matrix, output_matrix, symmetric, observer).
+		on_progress() is called from the worker threads, one at a time, and the hardware counters are those of the calling thread
+	*/
+	static bool run(int src_n, const T *input_matrix, T *output_matrix, bool symmetric, int n_threads, observe::observer &observer) {
+		parallel::thread_pool pool(n_threads);
+		return base::run_observed(src_n, input_matrix, output_matrix, symmetric, observer, [&pool] (int n_blocks_power2, int n_blocks,
+			const blocks_t &blocks, bool symmetric, mask_t &mask, observe::tracker *tracker) {
+			FWR(pool, n_blocks_power2, n_blocks, 0, 0, 0, blocks, symmetric, mask, tracker);
+		});
+	}
+	/*
+		Same as floyd_warshall::run_components, but the components are solved as parallel tasks of one pool,
+		each of which also runs its FWR in parallel, so that many small components and a few large ones both keep the threads busy
+	*/
+	static void run_components(int src_n, const T *input_matrix, T *output_matrix, bool symmetric = false, int n_threads = 0) {
+		std::vector<typename base::component_t> components;
+		if (!base::split_components(src_n, input_matrix, components)) {
+			run(src_n, input_matrix, output_matrix, symmetric, n_threads);
+			return;
+		}
+		parallel::thread_pool pool(n_threads);
+		std::vector<std::function<void()> > tasks;
+		for (auto &component : components) if (component.vertices.size() > 1) tasks.push_back([&pool, &component, symmetric] () {
+			T *matrix = component.matrix.data();
+			base::run_reordered(component.vertices.size(), matrix, matrix, [&] (int n_blocks_power2, int n_blocks, const blocks_t &blocks) {
+				solve(pool, n_blocks_power2, n_blocks, blocks, symmetric);
+			}, symmetric);
+		});
+		pool.run_all(tasks.data(), tasks.size());
+		base::merge_components(src_n, components, output_matrix);
+	}
+};
+
+/*
+	floyd_warshall::run(src_n, input_matrix, output_matrix, symmetric) keeping its working memory between the calls:
+	the blocked copy of the matrix is placed in a grow-only workspace(see storage::workspace), which is backed by huge pages and pre-faulted,
+	and the flags of the all-INF blocks keep their memory likewise, so the solves of graphs no larger than before allocate nothing.
+	The result is the same as floyd_warshall::run. An object must not be used by multiple threads at a time
+*/
+template<InstSet inst_set, typename T, int unroll_type, int block_size = 64> class reusable_floyd_warshall {
+	using base = floyd_warshall<inst_set, T, unroll_type, block_size>;
+	using blocks_t = typename base::blocks_t;
+	using mask_t = typename base::mask_t;
+public:
+	static constexpr T INF = base::INF;
+	using value_t = T;
+	
+	static std::string get_description() { return "reusable_" + base::get_description(); }
+	
+	// grows the workspace for graphs with up to src_n vertices beforehand; returns false if the memory cannot be mapped
+	bool reserve(int src_n, bool symmetric = false) {
+		const int n_blocks = (src_n + block_size - 1) / block_size;
+		return src_n == 0 || workspace.reserve(blocked_matrix<T, block_size>::buffer_size(n_blocks, symmetric));
+	}
+	// same as floyd_warshall::run(src_n, input_matrix, output_matrix, symmetric)
+	void run(int src_n, const T *input_matrix, T *output_matrix, bool symmetric = false) {
+		base::run_reordered(src_n, input_matrix, output_matrix, [this, symmetric] (int n_blocks_power2, int n_blocks, const blocks_t &blocks) {
+			base::find_inf_blocks(n_blocks, blocks, mask);
+			base::solve(n_blocks_power2, n_blocks, blocks, symmetric, mask, nullptr);
+		}, symmetric, &workspace);
+	}
+	const storage::workspace &get_workspace() const { return workspace; }
+private:
+	storage::workspace workspace;
+	mask_t mask;
+};
+
+/*
+	The blocked Floyd-Warshall algorithm distributed over the ranks of a transport(see distributed::transport),
+	for graphs whose matrix or work is too large for one machine.
+	The BxB blocks are distributed 2D block-cyclically over a grid of p_rows x p_columns ranks(the squarest one for transport.size()):
+	block (i, j) belongs to rank (i % p_rows) * p_columns + j % p_columns, which is the only one holding it.
+	In phase k(for k = 0, 1, ..., n_blocks - 1), the diagonal block (k, k) is closed, the blocks of row k and column k are updated with it,
+	and each of them is broadcast to the ranks of its grid column / grid row, which update every other block (i, j) of theirs
+	with (i, k) and (k, j) by MaxPlusMul. The ranks agree on a single order of all the transfers, which are run by a thread of their own,
+	and row and column k + 1 are updated first in phase k(one-phase lookahead) so that the transfers of phase k + 1 overlap with the rest of phase k.
+	The result is the same as floyd_warshall::run except for the rounding of float and double
+*/
+template<InstSet inst_set, typename T, int unroll_type, int block_size = 64> class distributed_floyd_warshall {
+	using base = floyd_warshall<inst_set, T, unroll_type, block_size>;
+	static constexpr int B = block_size;
+public:
+	static constexpr T INF = base::INF;
+	using value_t = T;
+
+	static std::string get_description() { return "distributed_" + base::get_description(); }
+private:
+	// the blocks and the transfers of one rank
+	class engine {
+	public:
+		engine (distributed::transport &transport, int src_n) : transport(transport), src_n(src_n) {
+			n_blocks = (src_n + B - 1) / B;
+			p_rows = 1;
+			for (int p = 1; p * p <= transport.size(); p++) if (transport.size() % p == 0) p_rows = p;
+			p_columns = transport.size() / p_rows;
+			my_row = transport.rank() / p_columns;
+			my_column = transport.rank() % p_columns;
+			n_local_rows = std::max(0, (n_blocks - my_row + p_rows - 1) / p_rows);
+			n_local_columns = std::max(0, (n_blocks - my_column + p_columns - 1) / p_columns);
+			local = base::allocate_aligned(std::max<size_t>(1, (size_t) n_local_rows * n_local_columns * B * B), local_org);
+			// two phases of the panels: the diagonal block, the blocks of row k in my grid column, those of column k in my grid row
+			slot_size = 1 + n_local_columns + n_local_rows;
+			panels = base::allocate_aligned((size_t) 2 * slot_size * B * B, panels_org);
+			panel_phase.assign(2 * slot_size, -1);
+		}
+		~engine () {
+			free(local_org);
+			free(panels_org);
+		}
+		bool owns(int i, int j) const { return i % p_rows == my_row && j % p_columns == my_column; }
+		T *block(int i, int j) const { return local + ((size_t) (i / p_rows) * n_local_columns + j / p_columns) * B * B; }
+		template<typename Weight> void import(const Weight &weight) {
+			for (int i = my_row; i < n_blocks; i += p_rows) for (int j = my_column; j < n_blocks; j += p_columns) {
+				T *dst = block(i, j);
+				for (int y = 0; y < B; y++) for (int x = 0; x < B; x++) {
+					const int u = i * B + y, v = j * B + x;
+					dst[y * B + x] = base::encode(u < src_n && v < src_n ? (T) weight(u, v) : INF);
+				}
+			}
+		}
+		bool solve() {
+			std::thread transfer_thread([this] () { transfer(); });
+			compute();
+			transfer_thread.join();
+			return !failed;
+		}
+		template<typename Distance> void for_each_result(const Distance &distance) const {
+			for (int i = my_row; i < n_blocks; i += p_rows) for (int j = my_column; j < n_blocks; j += p_columns) {
+				const T *src = block(i, j);
+				for (int y = 0; y < B && i * B + y < src_n; y++) for (int x = 0; x < B && j * B + x < src_n; x++)
+					distance(i * B + y, j * B + x, base::encode(src[y * B + x]));
+			}
+		}
+		// sends the blocks to rank 0, which writes them to output_matrix
+		bool gather(T *output_matrix) {
+			const int rank = transport.rank();
+			std::vector<T> buffer(B * B);
+			for (int i = 0; i < n_blocks; i++) for (int j = 0; j < n_blocks; j++) {
+				const int block_owner = owner(i, j);
+				const T *src = block_owner == rank ? block(i, j) : buffer.data();
+				if (block_owner != rank && rank == 0 && !transport.recv(block_owner, buffer.data(), B * B * sizeof(T))) return false;
+				if (block_owner == rank && rank != 0 && !transport.send(0, src, B * B * sizeof(T))) return false;
+				if (rank != 0) continue;
+				for (int y = 0; y < B && i * B + y < src_n; y++) for (int x = 0; x < B && j * B + x < src_n; x++)
+					output_matrix[(size_t) (i * B + y) * src_n + j * B + x] = base::encode(src[y * B + x]);
+			}
+			return true;
+		}
+	private:
+		distributed::transport &transport;
+		const int src_n;
+		int n_blocks;
+		int p_rows, p_columns; // the shape of the grid of the ranks
+		int my_row, my_column; // the position of this rank in the grid
+		int n_local_rows, n_local_columns; // the numbers of the block rows / columns held by this rank
+		void *local_org = nullptr;
+		T *local;
+		size_t slot_size;
+		void *panels_org = nullptr;
+		T *panels;
+
+		// the states shared by the compute thread and the transfer thread
+		std::mutex mutex;
+		std::condition_variable cond;
+		std::vector<int> panel_phase; // the phase whose block is in each panel, -1 if none yet
+		int computed = -1; // the last phase whose updates are all done
+		int transferred = -1; // the last phase whose transfers are all done
+		bool failed = false;
+
+		int owner(int i, int j) const { return (i % p_rows) * p_columns + j % p_columns; }
+		// the index of the panel of phase k holding the diagonal block, (k, j), or (i, k)
+		size_t diagonal_panel(int k) const { return (k % 2) * slot_size; }
+		size_t row_panel(int k, int j) const { return (k % 2) * slot_size + 1 + j / p_columns; }
+		size_t column_panel(int k, int i) const { return (k % 2) * slot_size + 1 + n_local_columns + i / p_rows; }
+		T *panel(size_t index) const { return panels + index * B * B; }
+
+		// waits until pred() holds; returns false if the solve failed
+		template<typename Pred> bool wait(const Pred &pred) {
+			std::unique_lock<std::mutex> lock(mutex);
+			cond.wait(lock, [&] { return failed || pred(); });
+			return !failed;
+		}
+		template<typename Update> void notify(const Update &update) {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				update();
+			}
+			cond.notify_all();
+		}
+		bool wait_panel(size_t index, int k) { return wait([&] { return panel_phase[index] == k; }); }
+		// publishes the updated block of phase k to the panel for the local updates and the transfer
+		void publish(size_t index, const T *src, int k) {
+			memcpy(panel(index), src, B * B * sizeof(T));
+			notify([&] { panel_phase[index] = k; });
+		}
+		/*
+			The transfers of phase k in the order shared by all the ranks:
+			the diagonal block to the grid row and column of k, then the blocks of row k to their grid columns, and those of column k to their grid rows.
+			transfer(root, destinations, index) sends or receives the panel index of this rank if it is involved.
+			Stops and returns false when transfer() returns false
+		*/
+		template<typename Transfer> bool for_each_transfer(int k, const Transfer &transfer) const {
+			std::vector<int> destinations;
+			for (int r = 0; r < p_rows; r++) if (r != k % p_rows) destinations.push_back(r * p_columns + k % p_columns);
+			for (int c = 0; c < p_columns; c++) if (c != k % p_columns) destinations.push_back((k % p_rows) * p_columns + c);
+			if (!transfer(owner(k, k), destinations, diagonal_panel(k))) return false;
+			for (int j = 0; j < n_blocks; j++) if (j != k) {
+				destinations.clear();
+				for (int r = 0; r < p_rows; r++) if (r != k % p_rows) destinations.push_back(r * p_columns + j % p_columns);
+				if (!transfer(owner(k, j), destinations, j % p_columns == my_column ? row_panel(k, j) : 0)) return false;
+			}
+			for (int i = 0; i < n_blocks; i++) if (i != k) {
+				destinations.clear();
+				for (int c = 0; c < p_columns; c++) if (c != k % p_columns) destinations.push_back((i % p_rows) * p_columns + c);
+				if (!transfer(owner(i, k), destinations, i % p_rows == my_row ? column_panel(k, i) : 0)) return false;
+			}
+			return true;
+		}
+		void transfer() {
+			const int rank = transport.rank();
+			const size_t size = B * B * sizeof(T);
+			for (int k = 0; k < n_blocks; k++) {
+				// the panels of phase k were last used in phase k - 2
+				if (!wait([&] { return computed >= k - 2; })) return;
+				bool ok = for_each_transfer(k, [&] (int root, const std::vector<int> &destinations, size_t index) {
+					bool ok = true;
+					if (root == rank) {
+						if (!wait_panel(index, k)) return false;
+						for (int destination : destinations) ok = ok && transport.send(destination, panel(index), size);
+					} else if (std::find(destinations.begin(), destinations.end(), rank) != destinations.end()) {
+						ok = transport.recv(root, panel(index), size);
+						if (ok) notify([&] { panel_phase[index] = k; });
 					}
-				} else {
-					if (!rev) std::fill(dst_head + i * B, dst_head + (i + 1) * B, -INF);
+					return ok;
+				});
+				if (!ok) {
+					notify([&] { failed = true; });
+					return;
 				}
+				notify([&] { transferred = k; });
 			}
-			block_start[block_row * n_blocks + block_column] = dst_head;
-			return dst_head + B * B;
-		} else {
-			int n_blocks_p2_half = n_blocks_power2 >> 1;
-			// split into 2x2 recursively
-			for (int i = 0; i < 2; i++) for (int j = 0; j < 2; j++)
-				dst_head = reorder(src_n, n_blocks_p2_half, dst_head, src, block_start,
-					block_row + i * n_blocks_p2_half, block_column + j * n_blocks_p2_half, rev);
-			return dst_head;
 		}
+		// closes the diagonal block of phase k and updates the blocks of row k and column k of this rank with it
+		bool update_panels(int k) {
+			// the panels of phase k were last sent or received in phase k - 2
+			if (!wait([&] { return transferred >= k - 2; })) return false;
+			if (owns(k, k)) {
+				T *diagonal = block(k, k);
+				base::FWI(diagonal, diagonal, diagonal);
+				publish(diagonal_panel(k), diagonal, k);
+			}
+			const bool has_row = k % p_rows == my_row, has_column = k % p_columns == my_column;
+			if (!has_row && !has_column) return true;
+			if (!wait_panel(diagonal_panel(k), k)) return false;
+			T *diagonal = panel(diagonal_panel(k));
+			if (has_row) for (int j = my_column; j < n_blocks; j += p_columns) if (j != k) {
+				base::FWI(block(k, j), diagonal, block(k, j));
+				publish(row_panel(k, j), block(k, j), k);
+			}
+			if (has_column) for (int i = my_row; i < n_blocks; i += p_rows) if (i != k) {
+				base::FWI(block(i, k), block(i, k), diagonal);
+				publish(column_panel(k, i), block(i, k), k);
+			}
+			return true;
+		}
+		bool update(int k, int i, int j) {
+			if (!wait_panel(column_panel(k, i), k) || !wait_panel(row_panel(k, j), k)) return false;
+			base::FWI(block(i, j), panel(column_panel(k, i)), panel(row_panel(k, j)));
+			return true;
+		}
+		void compute() {
+			bool ok = n_blocks == 0 || update_panels(0);
+			for (int k = 0; ok && k < n_blocks; k++) {
+				auto in_lookahead = [k] (int i, int j) { return i == k + 1 || j == k + 1; };
+				for (int i = my_row; ok && i < n_blocks; i += p_rows) for (int j = my_column; ok && j < n_blocks; j += p_columns)
+					if (i != k && j != k && in_lookahead(i, j)) ok = update(k, i, j);
+				if (ok && k + 1 < n_blocks) ok = update_panels(k + 1);
+				for (int i = my_row; ok && i < n_blocks; i += p_rows) for (int j = my_column; ok && j < n_blocks; j += p_columns)
+					if (i != k && j != k && !in_lookahead(i, j)) ok = update(k, i, j);
+				if (ok) notify([&] { computed = k; });
+			}
+			if (!ok) notify([&] { failed = true; });
+		}
+	};
+public:
+	/*
+		Solves the src_n * src_n graph, called by every rank of transport with the same src_n.
+		weight(i, j) gives the weight of the edge from i to j(INF if none) only for the elements in the blocks of this rank,
+		and distance(i, j, d) receives the distances for them, so no rank needs the whole matrix.
+		Returns false if the transport fails
+	*/
+	template<typename Weight, typename Distance> static bool run_scattered(distributed::transport &transport, int src_n, const Weight &weight, const Distance &distance) {
+		engine solver(transport, src_n);
+		solver.import(weight);
+		if (!solver.solve()) return false;
+		solver.for_each_result(distance);
+		return true;
 	}
+	/*
+		Same as floyd_warshall::run(src_n, input_matrix, output_matrix) with input_matrix given to every rank;
+		the result is gathered to rank 0 and written to output_matrix there(may be nullptr on the other ranks)
+	*/
+	static bool run(distributed::transport &transport, int src_n, const T *input_matrix, T *output_matrix) {
+		engine solver(transport, src_n);
+		solver.import([input_matrix, src_n] (int i, int j) { return input_matrix[(size_t) i * src_n + j]; });
+		return solver.solve() && solver.gather(output_matrix);
+	}
+};
+
+/*
+	src_n * src_n boolean matrix stored as bits in the layout transitive_closure<*, block_size> works on:
+	split into block_size x block_size blocks placed in the Z-order(see block_table), each of them row-major with block_size / 64 words per row
+	(column j of a row is bit j % 64 of its word j / 64), and the padding up to a multiple of block_size filled with 0.
+	n vertices take about n * n / 8 bytes, e.g. 512 MB for 65535
+*/
+template<int block_size = 512> class bit_matrix {
+	template<InstSet, int> friend struct transitive_closure;
 public:
-	static void run(int src_n, const T *input_matrix, T *output_matrix, bool symmetric = false) {
-		assert(0 <= src_n && src_n < 65536);
+	bit_matrix () = default;
+	// src_n vertices with no edges
+	explicit bit_matrix (int src_n) { allocate(src_n); }
+	// matrix : src_n * src_n row-major matrix, where matrix[i * src_n + j] tells whether there is an edge from i to j
+	bit_matrix (int src_n, const bool *matrix) {
+		allocate(src_n);
+		for (int i = 0; i < src_n; i++) for (int j = 0; j < src_n; j++) if (matrix[(size_t) i * src_n + j]) set(i, j, true);
+	}
+	bit_matrix (const bit_matrix &rhs) {
+		allocate(rhs.src_n);
+		if (src_n) memcpy(blocks.data(), rhs.blocks.data(), buffer_size());
+	}
+	bit_matrix (bit_matrix &&rhs) { swap(rhs); }
+	bit_matrix &operator = (bit_matrix rhs) { swap(rhs); return *this; }
+	~bit_matrix () { free(buffer_org); }
+	void swap(bit_matrix &rhs) {
+		std::swap(src_n, rhs.src_n);
+		std::swap(n_blocks, rhs.n_blocks);
+		std::swap(n_blocks_power2, rhs.n_blocks_power2);
+		std::swap(buffer_org, rhs.buffer_org);
+		std::swap(blocks, rhs.blocks);
+	}
+	
+	int size() const { return src_n; }
+	bool get(int i, int j) const { return word(i, j) >> (j % 64) & 1; }
+	void set(int i, int j, bool value) {
+		if (value) word(i, j) |= (uint64_t) 1 << (j % 64);
+		else word(i, j) &= ~((uint64_t) 1 << (j % 64));
+	}
+	// writes the src_n * src_n row-major matrix in the same format as the constructor takes
+	void to_matrix(bool *matrix) const {
+		for (int block_row = 0; block_row < n_blocks; block_row++) for (int block_column = 0; block_column < n_blocks; block_column++) {
+			const uint64_t *src = blocks(block_row, block_column);
+			const int length = std::min(B, src_n - block_column * B);
+			for (int y = 0; y < B && block_row * B + y < src_n; y++) {
+				bool *dst = matrix + (size_t) (block_row * B + y) * src_n + block_column * B;
+				for (int x = 0; x < length; x++) dst[x] = src[y * W + x / 64] >> (x % 64) & 1;
+			}
+		}
+	}
+private:
+	static constexpr int B = block_size;
+	static constexpr int W = B / 64; // the number of words in a row of a block
+	static_assert(B % 64 == 0, "Invalid block_size value");
+	int src_n = 0;
+	int n_blocks = 0; // number of BxB blocks in a row
+	int n_blocks_power2 = 0; // smallest power of 2 >= n_blocks
+	void *buffer_org = nullptr;
+	// a block of B x B bits is B * W = (B / 8)^2 words, i.e. the size of a block of block_table<uint64_t, B / 8>
+	block_table<uint64_t, B / 8> blocks;
+	
+	uint64_t &word(int i, int j) const { return blocks(i / B, j / B)[(i % B) * W + j % B / 64]; }
+	size_t buffer_size() const { return (size_t) n_blocks * n_blocks * B * W * sizeof(uint64_t); }
+	// allocates the 64-byte aligned buffer for src_n * src_n bits filled with 0
+	void allocate(int src_n) {
+		assert(0 <= src_n);
+		this->src_n = src_n;
 		if (src_n == 0) return;
-		int n_blocks = (src_n + B - 1) / B; // number of BxB blocks in a row
-		int n_blocks_power2 = 1; // smallest power of 2 >= src_n / B
-		while (n_blocks_power2 * B < src_n) n_blocks_power2 *= 2;
+		n_blocks = (src_n + B - 1) / B;
+		n_blocks_power2 = 1;
+		while (n_blocks_power2 < n_blocks) n_blocks_power2 *= 2;
+		size_t aligned_buffer_size = buffer_size() + 64;
+		buffer_org = malloc(aligned_buffer_size);
+		assert(buffer_org);
+		void *buffer = buffer_org;
+		void *aligned = std::align(64, buffer_size(), buffer, aligned_buffer_size);
+		assert(aligned);
+		memset(aligned, 0, buffer_size());
+		blocks = block_table<uint64_t, B / 8>((uint64_t *) aligned, n_blocks, n_blocks_power2);
+	}
+};
+
+/*
+	Transitive closure, i.e. Floyd-Warshall on the boolean semiring(OR, AND), for the queries only asking whether u can reach v.
+	The matrix is kept as bits(see bit_matrix), so the memory is 1/16 of int16_t and each vector operation handles 8 * vector_t::SIZE pairs,
+	and the blocks are processed in the same recursive order as floyd_warshall(FWR).
+	The result has bit (i, j) set iff there is a path of one or more edges from i to j,
+	i.e. where floyd_warshall::run gives a distance less than INF for the same edges.
+	block_size must be a multiple of the bits of a vector(512 for AVX512)
+*/
+template<InstSet inst_set, int block_size = 512> struct transitive_closure {
+	static std::string get_description() {
+		return "closure<" + vectorize::inst_set_to_str(inst_set) + ", " + std::to_string(block_size) + ">";
+	}
+	// computes the transitive closure of matrix in place
+	static void run(bit_matrix<block_size> &matrix) {
+		if (!matrix.src_n) return;
+		const auto &blocks = matrix.blocks;
+		recursion::FWR(matrix.n_blocks_power2, matrix.n_blocks, [&blocks] (int i, int k, int j) {
+			FWI(blocks(i, j), blocks(i, k), blocks(k, j));
+		});
+	}
+	// input_matrix, output_matrix : src_n * src_n row-major matrices of the edges / the reachability(may be the same)
+	static void run(int src_n, const bool *input_matrix, bool *output_matrix) {
+		bit_matrix<block_size> matrix(src_n, input_matrix);
+		run(matrix);
+		matrix.to_matrix(output_matrix);
+	}
+private:
+	static constexpr int B = block_size;
+	static constexpr int W = B / 64; // the number of words in a row of a block
+	using vector_t = vectorize::bit_vector_t<inst_set>;
+	static constexpr int L = vector_t::SIZE / sizeof(uint64_t); // the number of words in a vector
+	static constexpr int R = W / L; // the number of vectors in a row of a block
+	static_assert(B % (vector_t::SIZE * 8) == 0, "Invalid block_size value");
+	
+	/*
+		OrAndMul(a, b, c) :
+		 - a, b, c must not overlap
+		 - equivalent to:
+			for all i, j in [0, B):
+				a(i, j) |= OR{b(i, k) & c(k, j) | k in [0, B)}
+		Row i of a is kept in R vectors while the rows of c for the set bits of row i of b are ORed into it,
+		so the cost is proportional to the number of the set bits of b
+	*/
+	static void OrAndMul(uint64_t *a, uint64_t *b, uint64_t *c) {
+		for (int i = 0; i < B; i++) {
+			uint64_t *aa = a + i * W;
+			vector_t row[R];
+			for (int r = 0; r < R; r++) row[r] = vector_t(aa + r * L);
+			for (int w = 0; w < W; w++) for (uint64_t bits = b[i * W + w]; bits; bits &= bits - 1) {
+				uint64_t *cc = c + (w * 64 + __builtin_ctzll(bits)) * W;
+				for (int r = 0; r < R; r++) row[r] = row[r] | vector_t(cc + r * L);
+			}
+			for (int r = 0; r < R; r++) row[r].store(aa + r * L);
+		}
+	}
+	static void FWI(uint64_t *a, uint64_t *b, uint64_t *c) {
+		vectorize::target_region<inst_set>::call([a, b, c] () { FWI_kernel(a, b, c); });
+	}
+	static void FWI_kernel(uint64_t *a, uint64_t *b, uint64_t *c) {
+		if (a != b && a != c && b != c) {
+			OrAndMul(a, b, c);
+			return;
+		}
+		for (int k = 0; k < B; k++) {
+			uint64_t *cc = c + k * W;
+			for (int i = 0; i < B; i++) if (b[i * W + k / 64] >> (k % 64) & 1) {
+				uint64_t *aa = a + i * W;
+				for (int r = 0; r < R; r++) (vector_t(aa + r * L) | vector_t(cc + r * L)).store(aa + r * L);
+			}
+		}
+	}
+};
+
+/*
+	floyd_warshall for a blocked_matrix larger than the memory, kept in a memory-mapped file(blocked_matrix::map_file).
+	The recursion of FWR is cut at super-tiles of S x S blocks, each of which is a contiguous range of the file thanks to the Z-order,
+	and the steps on three super-tiles at that level are run one by one in the same order as FWR,
+	so the result is bit-identical to that of floyd_warshall<inst_set, T, unroll_type, block_size>::run(matrix).
+	Before each step, the super-tiles of the next step are prefetched(read by the OS in the background while the current step runs),
+	and after it, the super-tiles not used by the next step are written back and released,
+	so about six super-tiles are in memory at a time; S is the largest power of 2 for which they fit in memory_budget.
+	The input is always treated as non-symmetric
+*/
+template<InstSet inst_set, typename T, int unroll_type, int block_size = 64> struct out_of_core_floyd_warshall {
+private:
+	using base = floyd_warshall<inst_set, T, unroll_type, block_size>;
+	using matrix_t = blocked_matrix<T, block_size>;
+	static constexpr int B = block_size;
+public:
+	static constexpr T INF = base::INF;
+	using value_t = T;
+	
+	static std::string get_description() { return "out_of_core_" + base::get_description(); }
+private:
+	// FWR(block_index0, block_index1, block_index2) on super-tiles
+	struct step_t { int block_index0, block_index1, block_index2; };
+	// super-tile (block_row, block_column)
+	struct tile_t {
+		int block_row, block_column;
+		bool operator == (const tile_t &rhs) const { return block_row == rhs.block_row && block_column == rhs.block_column; }
+	};
+	// the steps on super-tiles of tile_size x tile_size blocks in the order of FWR(non-symmetric)
+	static void list_steps(int n_blocks_power2, int tile_size, int n_blocks, int block_index0, int block_index1, int block_index2,
+		std::vector<step_t> &steps) {
+		
+		if (block_index0 >= n_blocks || block_index1 >= n_blocks || block_index2 >= n_blocks) return;
+		if (n_blocks_power2 == tile_size) {
+			steps.push_back({ block_index0, block_index1, block_index2 });
+			return;
+		}
+		int half = n_blocks_power2 >> 1;
+		list_steps(half, tile_size, n_blocks, block_index0       , block_index1       , block_index2       , steps);
+		list_steps(half, tile_size, n_blocks, block_index0       , block_index1       , block_index2 + half, steps);
+		list_steps(half, tile_size, n_blocks, block_index0 + half, block_index1       , block_index2       , steps);
+		list_steps(half, tile_size, n_blocks, block_index0 + half, block_index1       , block_index2 + half, steps);
+		list_steps(half, tile_size, n_blocks, block_index0 + half, block_index1 + half, block_index2 + half, steps);
+		list_steps(half, tile_size, n_blocks, block_index0 + half, block_index1 + half, block_index2       , steps);
+		list_steps(half, tile_size, n_blocks, block_index0       , block_index1 + half, block_index2 + half, steps);
+		list_steps(half, tile_size, n_blocks, block_index0       , block_index1 + half, block_index2       , steps);
+	}
+	// the super-tiles written / read by a step
+	static std::array<tile_t, 3> tiles_of(const step_t &step) {
+		return {{
+			{ step.block_index0, step.block_index2 },
+			{ step.block_index0, step.block_index1 },
+			{ step.block_index1, step.block_index2 }
+		}};
+	}
+	// the number of bytes of super-tile in the buffer, which starts at its top-left block
+	static size_t tile_bytes(const matrix_t &matrix, int tile_size, const tile_t &tile) {
+		size_t n_rows = std::min(tile_size, matrix.n_blocks - tile.block_row);
+		size_t n_columns = std::min(tile_size, matrix.n_blocks - tile.block_column);
+		return n_rows * n_columns * B * B * sizeof(T);
+	}
+	static const T *tile_head(const matrix_t &matrix, const tile_t &tile) {
+		return matrix.blocks(tile.block_row, tile.block_column);
+	}
+public:
+	// S in blocks: the largest power of 2 up to the whole matrix such that six S x S super-tiles fit in memory_budget(at least 1)
+	static int get_tile_size(const matrix_t &matrix, size_t memory_budget) {
+		int tile_size = 1;
+		while (tile_size < matrix.n_blocks_power2 &&
+			6 * (size_t) (2 * tile_size * B) * (2 * tile_size * B) * sizeof(T) <= memory_budget) tile_size *= 2;
+		return tile_size;
+	}
+	/*
+		Solves matrix in place like floyd_warshall::run(matrix) while keeping about memory_budget bytes of it in memory.
+		An in-memory matrix is solved in the same order with no effect on the memory usage
+	*/
+	static void run(matrix_t &matrix, size_t memory_budget) {
+		if (matrix.size() == 0) return;
+		const int n_blocks = matrix.n_blocks;
+		const int tile_size = get_tile_size(matrix, memory_budget);
+		std::vector<step_t> steps;
+		list_steps(matrix.n_blocks_power2, tile_size, n_blocks, 0, 0, 0, steps);
+		
+		const block_table<T, B> &blocks = matrix.blocks;
+		// n_blocks^2 bytes in memory, built by reading the whole file once
+		typename base::mask_t mask = base::inf_blocks(n_blocks, blocks);
+		for (size_t t = 0; t < steps.size(); t++) {
+			const bool has_next = t + 1 < steps.size();
+			std::array<tile_t, 3> cur_tiles = tiles_of(steps[t]);
+			std::array<tile_t, 3> next_tiles = cur_tiles;
+			if (has_next) {
+				next_tiles = tiles_of(steps[t + 1]);
+				for (auto &tile : next_tiles) matrix.file.prefetch(tile_head(matrix, tile), tile_bytes(matrix, tile_size, tile));
+			}
+			const step_t &step = steps[t];
+			base::FWR(tile_size, n_blocks, step.block_index0, step.block_index1, step.block_index2, blocks, false, &mask,
+				[&blocks, &mask] (int i, int k, int j) {
+					base::FWI_sparse(i, k, j, blocks, mask, base::FWI);
+				});
+			for (auto &tile : cur_tiles) {
+				bool used_next = has_next && std::find(next_tiles.begin(), next_tiles.end(), tile) != next_tiles.end();
+				if (!used_next) matrix.file.release(tile_head(matrix, tile), tile_bytes(matrix, tile_size, tile));
+			}
+		}
+	}
+};
+
+/*
+	Keeps the solved distance matrix in the blocked layout of floyd_warshall and updates it
+	when an edge gets shorter or a vertex is added, in O(src_n^2) each instead of solving again in O(src_n^3).
+	The updates are rank-1 max-plus updates of the whole matrix done row by row with the vectors of inst_set.
+	The graph must not contain negative cycles; the updates that would create one are rejected.
+*/
+template<InstSet inst_set, typename T, int unroll_type, int block_size = 64> class incremental_floyd_warshall {
+	using base = floyd_warshall<inst_set, T, unroll_type, block_size>;
+	using vector_t = typename base::vector_t;
+	static constexpr int B = base::B;
+	static_assert(!std::is_unsigned<T>::value, "the saturating unsigned types are not supported");
+public:
+	static constexpr T INF = base::INF;
+	using value_t = T;
+	struct edge_t {
+		int from;
+		int to;
+		T weight;
+	};
+	
+	static std::string get_description() {
+		return "incremental<" + vectorize::inst_set_to_str(inst_set) + ", " + vectorize::type_to_str<value_t>() + ", "
+			+ std::to_string(unroll_type) + ", " + std::to_string(block_size) + ">"; 
+	}
+private:
+	int src_n = 0;
+	// the vertices in [src_n, matrix.size()) are the padding of the last block row
+	blocked_matrix<T, B> matrix;
+	
+	T &at(int i, int j) const { return matrix.at(i, j); }
+	// replaces the content with input_matrix(src_n * src_n) without solving it
+	void assign(int src_n, const T *input_matrix) {
+		this->src_n = src_n;
+		matrix = blocked_matrix<T, B>(src_n, input_matrix);
+	}
+	/*
+		The blocks in the block row containing a row, looked up once for consecutive rows in the same block row,
+		since looking up a block takes O(log n_blocks) (see block_table)
+	*/
+	class block_row_cache {
+	public:
+		explicit block_row_cache (const blocked_matrix<T, B> &matrix) : matrix(matrix), blocks(matrix.n_blocks) {}
+		T * const *get(int i) {
+			if (i / B != block_row) {
+				block_row = i / B;
+				for (int j_block = 0; j_block < matrix.n_blocks; j_block++) blocks[j_block] = matrix.blocks(block_row, j_block);
+			}
+			return blocks.data();
+		}
+	private:
+		const blocked_matrix<T, B> &matrix;
+		std::vector<T *> blocks;
+		int block_row = -1;
+	};
+	/*
+		x, or -INF if it is smaller.
+		With negative weights, the unreachable pairs hold INF plus a sum of negative weights instead of INF(as floyd_warshall::run gives),
+		which passes the checks for -INF, so the values made from them are kept from going below -INF
+		where adding another -INF could overflow
+	*/
+	static T clamp(T x) { return std::max<T>(x, -INF); }
+	// row i = max(row i, row k + coef) for the whole blocked rows, including the padding
+	// i_blocks, k_blocks : the blocks in the block rows containing row i, k
+	void relax_row(T * const *i_blocks, int i, T * const *k_blocks, int k, T coef) {
+		vector_t coef_vec(coef);
+		const int n_blocks = matrix.n_blocks;
+		int i_offset = (i % B) * B, k_offset = (k % B) * B;
+		for (int j_block = 0; j_block < n_blocks; j_block++) {
+			T *aa = i_blocks[j_block] + i_offset;
+			T *bb = k_blocks[j_block] + k_offset;
+			for (int j = 0; j < B; j += vector_t::SIZE / sizeof(T)) (vector_t(bb + j) + coef_vec).chmax_store(aa + j);
+		}
+	}
+	// max over j of (row i + values)[j], where i_blocks is the same as relax_row() and values is aligned and has matrix.n_blocks * B elements
+	T max_plus_row(T * const *i_blocks, int i, const T *values) const {
+		vector_t res(-INF);
+		const int n_blocks = matrix.n_blocks;
+		int i_offset = (i % B) * B;
+		for (int j_block = 0; j_block < n_blocks; j_block++) {
+			T *aa = i_blocks[j_block] + i_offset;
+			const T *bb = values + j_block * B;
+			for (int j = 0; j < B; j += vector_t::SIZE / sizeof(T))
+				res = max(res, vector_t(aa + j) + vector_t(const_cast<T *>(bb + j)));
+		}
+		alignas(64) T lanes[vector_t::SIZE / sizeof(T)];
+		res.store(lanes);
+		return *std::max_element(lanes, lanes + vector_t::SIZE / sizeof(T));
+	}
+public:
+	// solves input_matrix(src_n * src_n, same as floyd_warshall::run) and keeps the result
+	incremental_floyd_warshall(int src_n, const T *input_matrix) {
+		assign(src_n, input_matrix);
+		base::run(matrix);
+	}
+	
+	int size() const { return src_n; }
+	// the distance from u to v, INF if unreachable
+	T get(int u, int v) const { return -at(u, v); }
+	// writes the src_n * src_n distance matrix
+	void get_matrix(T *output_matrix) const {
+		for (int i = 0; i < src_n; i++) for (int j = 0; j < src_n; j++) output_matrix[(size_t) i * src_n + j] = -at(i, j);
+	}
+	/*
+		Makes the weight of the edge from u to v weight if it is smaller than the current distance from u to v.
+		Returns false without changing anything if it would create a negative cycle.
+		For each vertex i that reaches u, row i is relaxed by row v in O(src_n), so it takes O(src_n^2) in total
+	*/
+	bool decrease_edge(int u, int v, T weight) {
+		assert(0 <= u && u < src_n && 0 <= v && v < src_n);
+		if (-weight <= at(u, v)) return true;
+		if (at(v, u) - weight > 0) return false; // dist(v, u) + weight < 0
+		// the in-place update is safe because row v and column u don't change without negative cycles
+		vectorize::target_region<inst_set>::call([this, u, v, weight] () {
+			block_row_cache i_rows(matrix), v_rows(matrix);
+			T * const *v_blocks = v_rows.get(v);
+			for (int i = 0; i < src_n; i++) {
+				T dist_iu = at(i, u);
+				if (dist_iu > -INF) relax_row(i_rows.get(i), i, v_blocks, v, clamp(dist_iu - weight));
+			}
+		});
+		return true;
+	}
+	// decrease_edge() for each edge in order; stops at and returns false for the first edge that would create a negative cycle
+	bool decrease_edges(const edge_t *edges, int n_edges) {
+		for (int i = 0; i < n_edges; i++) if (!decrease_edge(edges[i].from, edges[i].to, edges[i].weight)) return false;
+		return true;
+	}
+	/*
+		Adds a vertex with index size() and edges to/from the existing vertices:
+			out_weights[i] : the weight of the edge from the new vertex to vertex i
+			in_weights[i] : the weight of the edge from vertex i to the new vertex
+		(INF if there is no edge, size() elements each).
+		Returns false without adding the vertex if it would create a negative cycle.
+		Takes O(src_n^2), plus O(src_n^2) to move to a larger buffer once in block_size additions
+	*/
+	bool add_vertex(const T *out_weights, const T *in_weights) {
+		const int new_vertex = src_n;
+		if (new_vertex == matrix.n_blocks * B) { // no padding left; move to a layout with one more row and column of blocks
+			// (T) INF : avoid binding the static constexpr member to the const reference of the constructor (ODR-use)
+			std::vector<T> grown((size_t) (src_n + 1) * (src_n + 1), (T) INF);
+			for (int i = 0; i < src_n; i++) for (int j = 0; j < src_n; j++) grown[(size_t) i * (src_n + 1) + j] = -at(i, j);
+			assign(src_n + 1, grown.data());
+			src_n = new_vertex;
+		}
+		// the row and the column of the padding may have been written by the updates
+		for (int i = 0; i < matrix.n_blocks * B; i++) at(new_vertex, i) = at(i, new_vertex) = -INF;
 		
-		// allocate and align the needed buffers
-		const size_t reordered_needed_size = (B * n_blocks) * (B * n_blocks) * sizeof(T);
-		size_t reordered_buffer_size = reordered_needed_size + 64;
-		void *reordered_org = malloc(reordered_buffer_size);
-		assert(reordered_org);
-		void *reordered = reordered_org;
-		assert(std::align(64, reordered_needed_size, reordered, reordered_buffer_size));
-		// block_start[i][j] : pointer to the starting element of the (i, j) block in t 
-		T **block_start = (T **) malloc(n_blocks * n_blocks * sizeof(T *));
-		std::fill(block_start, block_start + n_blocks * n_blocks, nullptr);
+		std::vector<T> neg_in_org(matrix.n_blocks * B + 64 / sizeof(T), -INF);
+		T *neg_in = neg_in_org.data();
+		while ((uintptr_t) neg_in % 64) neg_in++;
+		for (int i = 0; i < new_vertex; i++) if (in_weights[i] < INF) neg_in[i] = -in_weights[i];
 		
-		reorder(src_n, n_blocks_power2, (T *) reordered, const_cast<T *>(input_matrix), block_start, 0, 0, false);
-		FWR(n_blocks_power2, n_blocks, 0, 0, 0, block_start, symmetric);
-		reorder(src_n, n_blocks_power2, (T *) reordered, output_matrix, block_start, 0, 0, true);
+		bool has_negative_cycle = false;
+		vectorize::target_region<inst_set>::call([&] () {
+			// the paths from / to the new vertex don't pass the new vertex again, so they only need the current distances
+			block_row_cache rows(matrix), new_rows(matrix);
+			T * const *new_blocks = new_rows.get(new_vertex);
+			for (int k = 0; k < new_vertex; k++) if (out_weights[k] < INF) relax_row(new_blocks, new_vertex, rows.get(k), k, -out_weights[k]);
+			for (int j = new_vertex + 1; j < matrix.n_blocks * B; j++) at(new_vertex, j) = -INF;
+			for (int i = 0; i < new_vertex; i++) at(i, new_vertex) = clamp(max_plus_row(rows.get(i), i, neg_in));
+			if (max_plus_row(new_blocks, new_vertex, neg_in) > 0) {
+				has_negative_cycle = true;
+				return;
+			}
+			at(new_vertex, new_vertex) = 0;
+			for (int i = 0; i < new_vertex; i++) {
+				T dist_i_new = at(i, new_vertex);
+				if (dist_i_new > -INF) relax_row(rows.get(i), i, new_blocks, new_vertex, dist_i_new);
+			}
+		});
+		if (has_negative_cycle) return false;
+		src_n++;
+		return true;
+	}
+};
+
+/*
+	Chooses the instruction set at runtime(at the first call) from what the running CPU supports
+	and calls the corresponding floyd_warshall<inst_set, T, unroll_type, block_size>::run.
+	Since every kernel is compiled for its own instruction set, no -m options are needed
+	and the same binary runs at full speed on any x86-64 machine.
+	unroll_type and block_size are read from the tuning profile(see tuning.h) at the first call,
+	which can be created by autotune(). Defaults are used if the profile has no entry for the instruction set and T.
+*/
+template<typename T> struct floyd_warshall_dispatch {
+public:
+	static constexpr T INF = inf_value<T>();
+	using value_t = T;
+	
+	static InstSet get_inst_set() {
+		static const InstSet inst_set = vectorize::best_inst_set();
+		return inst_set;
+	}
+	static tuning::config_t &get_config() {
+		static tuning::config_t config = load_config();
+		return config;
+	}
+	static std::string get_description() { return "dispatch<" + vectorize::inst_set_to_str(get_inst_set()) + ", " +
+		vectorize::type_to_str<value_t>() + ", " + std::to_string(get_config().unroll_type) + ", " +
+		std::to_string(get_config().block_size) + ">"; }
+private:
+	static constexpr int BLOCK_SIZE_CANDIDATES[3] = { 32, 64, 128 };
+	
+	// the unroll_type that was the fastest for each instruction set and T in a benchmark with n = 1024 on an AVX-512 capable Xeon
+	static constexpr int default_unroll_type(InstSet inst_set) {
+		return inst_set == InstSet::AVX512 ? 1 :
+			inst_set == InstSet::AVX2 ? (sizeof(T) == 8 ? 0 : sizeof(T) == 4 ? 3 : 1) :
+			inst_set == InstSet::SSE4_2 ? (sizeof(T) == 4 ? 3 : 1) : 0;
+	}
+	static tuning::config_t load_config() {
+		tuning::config_t config = { 64, default_unroll_type(get_inst_set()) };
+		tuning::load(tuning::default_profile_path(), get_inst_set(), vectorize::type_to_str<T>(), config);
+		return config;
+	}
+	/*
+		An action holds the arguments (and the result) of a call and has
+			template<class Solver> void run()
+		which is called with Solver = floyd_warshall<inst_set, T, unroll_type, block_size> selected by run_with()
+	*/
+	struct solve_action {
+		int src_n;
+		const T *input_matrix;
+		T *output_matrix;
+		bool symmetric;
+		template<class Solver> void run() { Solver::run(src_n, input_matrix, output_matrix, symmetric); }
+	};
+	struct solve_observed_action {
+		int src_n;
+		const T *input_matrix;
+		T *output_matrix;
+		bool symmetric;
+		observe::observer &observer;
+		bool completed;
+		template<class Solver> void run() { completed = Solver::run(src_n, input_matrix, output_matrix, symmetric, observer); }
+	};
+	struct solve_sparse_action {
+		int src_n;
+		const T *input_matrix;
+		T *output_matrix;
+		bool symmetric;
+		template<class Solver> void run() { Solver::run_sparse(src_n, input_matrix, output_matrix, symmetric); }
+	};
+	struct solve_components_action {
+		int src_n;
+		const T *input_matrix;
+		T *output_matrix;
+		bool symmetric;
+		template<class Solver> void run() { Solver::run_components(src_n, input_matrix, output_matrix, symmetric); }
+	};
+	struct solve_checked_action {
+		int src_n;
+		const T *input_matrix;
+		T *output_matrix;
+		bool *reaches_negative_cycle;
+		bool has_negative_cycle;
+		template<class Solver> void run() {
+			has_negative_cycle = Solver::run_checked(src_n, input_matrix, output_matrix, reaches_negative_cycle);
+		}
+	};
+	struct min_plus_multiply_action {
+		int m, n, k;
+		const T *a;
+		const T *b;
+		T *c;
+		template<class Solver> void run() { Solver::min_plus_multiply(m, n, k, a, b, c); }
+	};
+	struct solve_batch_action {
+		int count;
+		int n;
+		const T *input_matrices;
+		T *output_matrices;
+		template<class Solver> void run() { Solver::run_batch(count, n, input_matrices, output_matrices); }
+	};
+	template<InstSet inst_set, int block_size, class Action> static void run_with(int unroll_type, Action &action) {
+		switch (unroll_type) {
+			case 0  : action.template run<floyd_warshall<inst_set, T, 0, block_size> >(); break;
+			case 1  : action.template run<floyd_warshall<inst_set, T, 1, block_size> >(); break;
+			case 2  : action.template run<floyd_warshall<inst_set, T, 2, block_size> >(); break;
+			default : action.template run<floyd_warshall<inst_set, T, 3, block_size> >(); break;
+		}
+	}
+	// block_size if it is a multiple of the number of T in a vector of inst_set(e.g. not 32 for AVX512 + uint8_t), 64 otherwise
+	template<InstSet inst_set> static constexpr int fit_block_size(int block_size) {
+		return block_size % (vectorize::vector_t<inst_set, T>::SIZE / sizeof(T)) == 0 ? block_size : 64;
+	}
+	template<InstSet inst_set, class Action> static void run_with(const tuning::config_t &config, Action &action) {
+		switch (config.block_size) {
+			case 32 : run_with<inst_set, fit_block_size<inst_set>(32) >(config.unroll_type, action); break;
+			case 128: run_with<inst_set, fit_block_size<inst_set>(128)>(config.unroll_type, action); break;
+			default : run_with<inst_set, 64>(config.unroll_type, action); break;
+		}
+	}
+	template<class Action> static void run_with(const tuning::config_t &config, Action &action) {
+		switch (get_inst_set()) {
+			case InstSet::AVX512 : run_with<InstSet::AVX512 >(config, action); break;
+			case InstSet::AVX2   : run_with<InstSet::AVX2   >(config, action); break;
+			case InstSet::SSE4_2 : run_with<InstSet::SSE4_2 >(config, action); break;
+			default              : run_with<InstSet::DEFAULT>(config, action); break;
+		}
+	}
+public:
+	static void run(int src_n, const T *input_matrix, T *output_matrix, bool symmetric = false) {
+		solve_action action = { src_n, input_matrix, output_matrix, symmetric };
+		run_with(get_config(), action);
+	}
+	// same as floyd_warshall::run(src_n, input_matrix, output_matrix, symmetric, observer)
+	static bool run(int src_n, const T *input_matrix, T *output_matrix, bool symmetric, observe::observer &observer) {
+		solve_observed_action action = { src_n, input_matrix, output_matrix, symmetric, observer, false };
+		run_with(get_config(), action);
+		return action.completed;
+	}
+	// same as floyd_warshall::run_sparse
+	static void run_sparse(int src_n, const T *input_matrix, T *output_matrix, bool symmetric = false) {
+		solve_sparse_action action = { src_n, input_matrix, output_matrix, symmetric };
+		run_with(get_config(), action);
+	}
+	// same as floyd_warshall::run_components
+	static void run_components(int src_n, const T *input_matrix, T *output_matrix, bool symmetric = false) {
+		solve_components_action action = { src_n, input_matrix, output_matrix, symmetric };
+		run_with(get_config(), action);
+	}
+	// same as floyd_warshall::run_checked
+	static bool run_checked(int src_n, const T *input_matrix, T *output_matrix, bool *reaches_negative_cycle = nullptr) {
+		solve_checked_action action = { src_n, input_matrix, output_matrix, reaches_negative_cycle, false };
+		run_with(get_config(), action);
+		return action.has_negative_cycle;
+	}
+	// same as floyd_warshall::run_batch
+	static void run_batch(int count, int n, const T *input_matrices, T *output_matrices) {
+		solve_batch_action action = { count, n, input_matrices, output_matrices };
+		run_with(get_config(), action);
+	}
+	// same as floyd_warshall::min_plus_multiply
+	static void min_plus_multiply(int m, int n, int k, const T *a, const T *b, T *c) {
+		min_plus_multiply_action action = { m, n, k, a, b, c };
+		run_with(get_config(), action);
+	}
+	/*
+		Measures every (block_size, unroll_type) candidate with get_inst_set() on a random dense graph with n vertices,
+		taking the minimum time of n_runs runs, and makes the fastest one the config used by run().
+		If save is true, it is also written to the tuning profile at profile_path.
+	*/
+	static tuning::config_t autotune(int n = 512, int n_runs = 3, bool save = true,
+		const std::string &profile_path = tuning::default_profile_path()) {
+		
+		std::mt19937 rnd;
+		std::vector<T> input((size_t) n * n), output((size_t) n * n);
+		// the sums saturate with unsigned types, so the weights need not be bounded by INF / n
+		const int64_t max_weight = std::is_unsigned<T>::value ? INF / 4 : std::min<double>(INF / std::max(1, n), 1 << 20);
+		for (int i = 0; i < n; i++) for (int j = 0; j < n; j++)
+			input[(size_t) i * n + j] = i == j ? 0 : std::uniform_int_distribution<int64_t>(1, max_weight)(rnd);
+		
+		tuning::config_t best_config = get_config();
+		double best_time = std::numeric_limits<double>::infinity();
+		for (int block_size : BLOCK_SIZE_CANDIDATES) for (int unroll_type = 0; unroll_type < 4; unroll_type++) {
+			tuning::config_t config = { block_size, unroll_type };
+			solve_action action = { n, input.data(), output.data(), false };
+			for (int i = 0; i < n_runs; i++) {
+				auto start = std::chrono::steady_clock::now();
+				run_with(config, action);
+				double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				if (time < best_time) best_time = time, best_config = config;
+			}
+		}
+		get_config() = best_config;
+		if (save) tuning::save(profile_path, get_inst_set(), vectorize::type_to_str<T>(), best_config);
+		return best_config;
+	}
+};
+template<typename T> constexpr int floyd_warshall_dispatch<T>::BLOCK_SIZE_CANDIDATES[3];
+
+/*
+	Solves in the narrowest value type that gives the same distances as floyd_warshall_dispatch<T>::run,
+	so that a caller keeping the weights in a wide T(e.g. int64_t) gets the speed of the narrow types whenever the graph allows.
+	The weights are scanned for their range first, and the candidates are the types narrower than T among
+	 - uint8_t, uint16_t, int32_t for the non-negative weights : the sums saturate at INF(or are kept below 2 * INF),
+		so a solve in type U gives min(INF_U, d) for each distance d.
+		U is provably safe if n * max_weight < INF_U, as no path or cycle has more than n edges.
+		The type one step narrower than the first safe one is also tried if the weights fit in it, and its result is verified:
+		it is exact iff max{finite result} + max_weight < INF_U(otherwise the type is promoted and the graph solved again)
+	 - int16_t, int32_t for the graphs with negative weights : only the provably safe ones(5 * n * max{|weight|} < INF_U,
+		which keeps the sums involving INF apart from the finite ones) are used, without verification.
+		The unreachable pairs get INF plus a sum of the weights as in T, which depends on the order of the updates even in T
+	The elements equal to INF are the missing edges. T itself is used if any other element is out of [-INF, INF).
+	The inputs outside the constraints of floyd_warshall::run(e.g. a negative cycle) have no guarantee of the same result
+*/
+template<typename T> struct adaptive_floyd_warshall {
+public:
+	static constexpr T INF = inf_value<T>();
+	using value_t = T;
+	static std::string get_description() { return "adaptive<" + vectorize::type_to_str<value_t>() + ">"; }
+	
+	/*
+		Same as floyd_warshall_dispatch<T>::run.
+		Returns sizeof the type the result was computed in, e.g. 2 if the distances fit in uint16_t or int16_t
+	*/
+	static int run(int src_n, const T *input_matrix, T *output_matrix, bool symmetric = false) {
+		const range_t range = scan(src_n, input_matrix);
+		if (range.valid && range.non_negative) {
+			if (solve_narrow<uint8_t , uint16_t>(src_n, input_matrix, output_matrix, symmetric, range)) return 1;
+			if (solve_narrow<uint16_t, int32_t >(src_n, input_matrix, output_matrix, symmetric, range)) return 2;
+			if (solve_narrow<int32_t , T       >(src_n, input_matrix, output_matrix, symmetric, range)) return 4;
+		} else if (range.valid) {
+			if (solve_narrow<int16_t, T>(src_n, input_matrix, output_matrix, symmetric, range)) return 2;
+			if (solve_narrow<int32_t, T>(src_n, input_matrix, output_matrix, symmetric, range)) return 4;
+		}
+		floyd_warshall_dispatch<T>::run(src_n, input_matrix, output_matrix, symmetric);
+		return sizeof(T);
+	}
+private:
+	struct range_t {
+		bool valid; // all the elements are in [-INF, INF], so that max_weight is exact
+		bool non_negative;
+		uint64_t max_weight; // max{|weight|} over the elements other than INF
+	};
+	// the range of the weights; the loop has no branches, so that it is vectorized by the compiler
+	static range_t scan(int src_n, const T *input_matrix) {
+		const size_t n_elements = (size_t) src_n * src_n;
+		T low = 0, high = 0;
+		bool above_inf = false;
+		for (size_t i = 0; i < n_elements; i++) {
+			const T weight = input_matrix[i];
+			above_inf |= weight > INF;
+			low = std::min(low, weight);
+			high = std::max(high, weight == INF ? (T) 0 : weight);
+		}
+		range_t range;
+		range.valid = std::is_integral<T>::value && !above_inf && low >= -INF;
+		range.non_negative = low >= 0;
+		range.max_weight = range.valid ? std::max<uint64_t>(high, (uint64_t) 0 - (uint64_t) (int64_t) low) : 0;
+		return range;
+	}
+	// whether U is safe without verification(see the comment of the class); T always is
+	template<typename U> static bool is_safe(int src_n, const range_t &range) {
+		if (std::is_same<U, T>::value) return true;
+		const uint64_t factor = (uint64_t) std::max(1, src_n) * (range.non_negative ? 1 : 5);
+		return range.max_weight <= ((uint64_t) inf_value<U>() - 1) / factor;
+	}
+	/*
+		Solves in U if it is narrower than T and either safe, or the non-negative weights fit in it and Wider(the next candidate) is safe.
+		Writes the result to output_matrix and returns true if the result is exact, otherwise leaves output_matrix untouched
+	*/
+	template<typename U, typename Wider> static bool solve_narrow(int src_n, const T *input_matrix, T *output_matrix, bool symmetric,
+		const range_t &range) {
 		
-		free(reordered_org);
-		free(block_start);
+		constexpr U NARROW_INF = inf_value<U>();
+		if (sizeof(U) >= sizeof(T)) return false;
+		const bool safe = is_safe<U>(src_n, range);
+		if (!safe && !(range.non_negative && range.max_weight < (uint64_t) NARROW_INF && is_safe<Wider>(src_n, range))) return false;
+		
+		const size_t n_elements = (size_t) src_n * src_n;
+		std::vector<U> matrix(n_elements);
+		for (size_t i = 0; i < n_elements; i++) matrix[i] = input_matrix[i] == INF ? NARROW_INF : (U) input_matrix[i];
+		floyd_warshall_dispatch<U>::run(src_n, matrix.data(), matrix.data(), symmetric);
+		if (!safe) {
+			uint64_t max_distance = 0;
+			for (size_t i = 0; i < n_elements; i++) if (matrix[i] != NARROW_INF) max_distance = std::max<uint64_t>(max_distance, matrix[i]);
+			// a distance not less than NARROW_INF would have a prefix of a finite distance followed by an edge reaching NARROW_INF
+			if (max_distance + range.max_weight >= (uint64_t) NARROW_INF) return false;
+		}
+		/*
+			the results are NARROW_INF for the unreachable pairs with the non-negative weights,
+			and NARROW_INF plus the sum of some edges with the negative weights, which is the same sum plus INF in T
+		*/
+		for (size_t i = 0; i < n_elements; i++) {
+			if (range.non_negative) output_matrix[i] = matrix[i] == NARROW_INF ? INF : (T) matrix[i];
+			else output_matrix[i] = matrix[i] > NARROW_INF / 2 ? (T) (INF - (T) (NARROW_INF - matrix[i])) : (T) matrix[i];
+		}
+		return true;
 	}
 };
 
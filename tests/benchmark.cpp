@@ -1,59 +1,251 @@
 #include <cstdio>
+#include <cstdlib>
+#include <cmath>
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
 #include <vector>
+#include <map>
 #include <algorithm>
 #include <numeric>
 #include "quick_floyd_warshall/qfw.h"
-#include "utils/utils.h"
+#include "utils/graphs.h"
 
 using namespace quick_floyd_warshall;
 
-template<class Runner> unsigned int benchmark(Random &random, int n, bool symmetric, double *time) {
-	using value_t = typename Runner::value_t;
-	std::vector<value_t> mat(n * n);
-	for (int i = 0; i < n; i++) for (int j = 0; j < i; j++) mat[i * n + j] = mat[j * n + i] = random.rnd_int(1, Runner::INF / n);
-	for (int i = 0; i < n; i++) mat[i * n + i] = 0;
-	
-	auto start = Timer::get();
-	for (int i = 0; i < 1; i++) Runner::run(n, mat.data(), mat.data(), symmetric);
-	auto end = Timer::get();
-	
-	if (time) *time = Timer::diff_s(start, end);
-	
-	uint32_t hash = mat.size();
-	for (auto i : mat) hash ^= std::hash<unsigned int>()(i) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+/*
+	Times floyd_warshall over every combination of
+		instruction set(those supported by the host) x value type x unroll type x symmetric x graph type(see generate_graph()) x size
+	and reports the min / median / standard deviation of the runs, the throughput, and the block traffic.
+
+	usage: benchmark [options]
+		--sizes 256,512,1024  : the numbers of vertices
+		--runs 5              : the number of timed runs of each configuration, after one untimed warm-up run
+		--inst-sets AVX2,...  : restrict the sweep to the given instruction sets / value types / unroll types / graph types,
+		--types int32_t,...     and to symmetric = false(0) / true(1)
+		--unroll 0,3
+		--graphs RANDOM_DENSE,...
+		--symmetric 0,1
+		--naive               : also time floyd_warshall_naive
+		--json FILE           : write the results also as JSON / CSV to FILE("-" for the standard output)
+		--csv FILE
+
+	The results of all the solvers on the same input are compared, and the exit code is 1 if any of them differ
+*/
+
+struct options_t {
+	std::vector<int> sizes = { 256, 512, 1024 };
+	int n_runs = 5;
+	std::vector<std::string> inst_sets, types, unroll_types, graphs, symmetric; // empty : everything
+	bool naive = false;
+	std::string json_path, csv_path;
+	FILE *log = stdout; // the human-readable lines go to stderr if JSON or CSV is written to stdout
+
+	static bool selected(const std::vector<std::string> &filter, const std::string &name) {
+		return filter.empty() || std::find(filter.begin(), filter.end(), name) != filter.end();
+	}
+};
+
+struct result_t {
+	std::string solver;
+	std::string inst_set;
+	std::string type;
+	int unroll_type; // -1 for the naive solver
+	bool symmetric;
+	std::string graph;
+	int n;
+	int n_runs;
+	double min_ms, median_ms, mean_ms, stddev_ms;
+	double gops; // n^3 min-plus updates(an addition and a comparison each) per second at the fastest run, in 10^9
+	double gbps; // the block traffic per second at the fastest run, in 10^9 bytes(see block_traffic())
+	uint32_t checksum;
+};
+
+static std::vector<std::string> split(const std::string &str) {
+	std::vector<std::string> res;
+	std::stringstream stream(str);
+	std::string item;
+	while (std::getline(stream, item, ',')) if (!item.empty()) res.push_back(item);
+	return res;
+}
+
+static bool parse_options(int argc, char **argv, options_t &options) {
+	for (int i = 1; i < argc; i++) {
+		const std::string arg = argv[i];
+		if (arg == "--naive") {
+			options.naive = true;
+			continue;
+		}
+		if (i + 1 >= argc) return false;
+		const std::string value = argv[++i];
+		if (arg == "--sizes") {
+			options.sizes.clear();
+			for (auto &size : split(value)) options.sizes.push_back(std::atoi(size.c_str()));
+		} else if (arg == "--runs") options.n_runs = std::max(1, std::atoi(value.c_str()));
+		else if (arg == "--inst-sets") options.inst_sets = split(value);
+		else if (arg == "--types") options.types = split(value);
+		else if (arg == "--unroll") options.unroll_types = split(value);
+		else if (arg == "--graphs") options.graphs = split(value);
+		else if (arg == "--symmetric") options.symmetric = split(value);
+		else if (arg == "--json") options.json_path = value;
+		else if (arg == "--csv") options.csv_path = value;
+		else return false;
+	}
+	return true;
+}
+
+/*
+	The bytes moved between the cache and the registers by the blocked algorithm for n vertices,
+	assuming every FWI on 64 x 64 blocks reads three blocks and writes one(no block skipped, symmetric or not).
+	It is a model to compare the configurations with each other and with the bandwidth of the caches, not a measurement
+*/
+static double block_traffic(int n, size_t value_size) {
+	const double n_blocks = (n + 63) / 64;
+	return n_blocks * n_blocks * n_blocks * 4 * 64 * 64 * value_size;
+}
+
+template<typename T> static uint32_t checksum(const std::vector<T> &matrix) {
+	uint32_t hash = matrix.size();
+	for (auto x : matrix) hash ^= std::hash<T>()(x) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
 	return hash;
 }
 
-template<class Runner> bool test_multi(int n, int n_testcase, bool symmetric = false) {
-	Random random;
-	
-	std::vector<double> time(n_testcase);
-	for (int i = 0; i < n_testcase; i++) {
-		unsigned int hash = benchmark<Runner>(random, n, symmetric, &time[i]);
-		fprintf(stderr, "%u ", hash);
+// an input of the sweep shared by all the solvers
+template<typename T> struct case_t {
+	GraphType graph_type;
+	int n;
+	bool symmetric;
+	std::vector<T> matrix;
+};
+
+template<class Solver> static void measure(const options_t &options, const case_t<typename Solver::value_t> &input,
+	const std::string &inst_set, int unroll_type, std::vector<result_t> &results) {
+
+	using T = typename Solver::value_t;
+	const int n = input.n;
+	std::vector<T> output(input.matrix.size());
+	Solver::run(n, input.matrix.data(), output.data(), input.symmetric); // warm-up
+	std::vector<double> time(options.n_runs);
+	for (auto &t : time) {
+		auto start = Timer::get();
+		Solver::run(n, input.matrix.data(), output.data(), input.symmetric);
+		t = Timer::diff_ms(start, Timer::get());
 	}
-	fprintf(stderr, "\n");
-	
 	std::sort(time.begin(), time.end());
-	for (auto &i : time) i *= 1000; // convert to ms
-	double mean = std::accumulate(time.begin(), time.end(), 0.0) / n_testcase;
-	double sd = 0;
-	for (auto i : time) sd += (i - mean) * (i - mean);
-	sd /= n_testcase;
-	sd = sqrt(sd);
-	
-	printf("[%7.2f ms | %7.2f ms | %7.2f ms]  Avg:%7.2f ms  SD:%.2f ms\n", time.front(), time[time.size() / 2], time.back(), mean, sd);
-	// for (auto i : time) std::cerr << "  " << (i - time.front()) * 1000 << " us" << std::endl;
-	
-	return true;
+	const double mean = std::accumulate(time.begin(), time.end(), 0.0) / time.size();
+	double variance = 0;
+	for (auto t : time) variance += (t - mean) * (t - mean);
+
+	result_t result;
+	result.solver = Solver::get_description();
+	result.inst_set = inst_set;
+	result.type = vectorize::type_to_str<T>();
+	result.unroll_type = unroll_type;
+	result.symmetric = input.symmetric;
+	result.graph = graph_type_to_str(input.graph_type);
+	result.n = n;
+	result.n_runs = time.size();
+	result.min_ms = time.front();
+	result.median_ms = time.size() % 2 ? time[time.size() / 2] : (time[time.size() / 2 - 1] + time[time.size() / 2]) / 2;
+	result.mean_ms = mean;
+	result.stddev_ms = std::sqrt(variance / time.size());
+	result.gops = (double) n * n * n / (result.min_ms * 1e6);
+	result.gbps = block_traffic(n, sizeof(T)) / (result.min_ms * 1e6);
+	result.checksum = checksum(output);
+	results.push_back(result);
+
+	fprintf(options.log, "%-36s %-8s sym=%d %-12s n=%-5d : min %9.3f ms  median %9.3f ms  sd %8.3f ms  %7.2f GOPS  %7.1f GB/s\n",
+		result.solver.c_str(), result.type.c_str(), (int) result.symmetric, result.graph.c_str(), n,
+		result.min_ms, result.median_ms, result.stddev_ms, result.gops, result.gbps);
+	fflush(options.log);
+}
+
+template<InstSet inst_set, typename T> static void sweep_unroll_types(const options_t &options, const case_t<T> &input, std::vector<result_t> &results) {
+	const std::string name = vectorize::inst_set_to_str(inst_set);
+	if (!options_t::selected(options.inst_sets, name) || !vectorize::is_supported(inst_set)) return;
+	if (options_t::selected(options.unroll_types, "0")) measure<floyd_warshall<inst_set, T, 0> >(options, input, name, 0, results);
+	if (options_t::selected(options.unroll_types, "1")) measure<floyd_warshall<inst_set, T, 1> >(options, input, name, 1, results);
+	if (options_t::selected(options.unroll_types, "2")) measure<floyd_warshall<inst_set, T, 2> >(options, input, name, 2, results);
+	if (options_t::selected(options.unroll_types, "3")) measure<floyd_warshall<inst_set, T, 3> >(options, input, name, 3, results);
 }
 
-int main() {
-	int size, n_testcase;
-	scanf("%d%d", &size, &n_testcase);
-	
-	test_multi<floyd_warshall_naive<int64_t> >(size, n_testcase);
-	test_multi<floyd_warshall<InstSet::AVX2, int64_t, 3> >(size, n_testcase);
-	return 0;
+template<typename T> static void sweep_type(const options_t &options, std::vector<result_t> &results) {
+	if (!options_t::selected(options.types, vectorize::type_to_str<T>())) return;
+	for (GraphType graph_type : { GraphType::RANDOM_DENSE, GraphType::RANDOM_PATH, GraphType::MAX_PATH }) {
+		if (!options_t::selected(options.graphs, graph_type_to_str(graph_type))) continue;
+		for (int n : options.sizes) for (bool symmetric : { false, true }) {
+			if (!options_t::selected(options.symmetric, symmetric ? "1" : "0")) continue;
+			Random random;
+			case_t<T> input = { graph_type, n, symmetric, generate_graph<T>(random, n, symmetric, graph_type, floyd_warshall_naive<T>::INF) };
+			if (options.naive) measure<floyd_warshall_naive<T> >(options, input, "-", -1, results);
+			sweep_unroll_types<InstSet::DEFAULT, T>(options, input, results);
+			sweep_unroll_types<InstSet::SSE4_2 , T>(options, input, results);
+			sweep_unroll_types<InstSet::AVX2   , T>(options, input, results);
+			sweep_unroll_types<InstSet::AVX512 , T>(options, input, results);
+		}
+	}
+}
+
+static void write_json(std::ostream &stream, const std::vector<result_t> &results) {
+	stream << "[\n";
+	for (size_t i = 0; i < results.size(); i++) {
+		const result_t &r = results[i];
+		stream << "  {\"solver\": \"" << r.solver << "\", \"inst_set\": \"" << r.inst_set << "\", \"type\": \"" << r.type
+			<< "\", \"unroll_type\": " << r.unroll_type << ", \"symmetric\": " << (r.symmetric ? "true" : "false")
+			<< ", \"graph\": \"" << r.graph << "\", \"n\": " << r.n << ", \"runs\": " << r.n_runs
+			<< ", \"min_ms\": " << r.min_ms << ", \"median_ms\": " << r.median_ms << ", \"mean_ms\": " << r.mean_ms
+			<< ", \"stddev_ms\": " << r.stddev_ms << ", \"gops\": " << r.gops << ", \"gbps\": " << r.gbps
+			<< ", \"checksum\": " << r.checksum << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	stream << "]\n";
+}
+static void write_csv(std::ostream &stream, const std::vector<result_t> &results) {
+	stream << "solver,inst_set,type,unroll_type,symmetric,graph,n,runs,min_ms,median_ms,mean_ms,stddev_ms,gops,gbps,checksum\n";
+	for (auto &r : results) stream << "\"" << r.solver << "\"," << r.inst_set << "," << r.type << "," << r.unroll_type << ","
+		<< r.symmetric << "," << r.graph << "," << r.n << "," << r.n_runs << "," << r.min_ms << "," << r.median_ms << ","
+		<< r.mean_ms << "," << r.stddev_ms << "," << r.gops << "," << r.gbps << "," << r.checksum << "\n";
+}
+template<typename Writer> static bool write(const std::string &path, const std::vector<result_t> &results, Writer writer) {
+	if (path.empty()) return true;
+	if (path == "-") {
+		writer(std::cout, results);
+		return true;
+	}
+	std::ofstream file(path);
+	writer(file, results);
+	return (bool) file;
+}
+
+int main(int argc, char **argv) {
+	options_t options;
+	if (!parse_options(argc, argv, options)) {
+		fprintf(stderr, "usage: %s [--sizes N,...] [--runs R] [--inst-sets S,...] [--types T,...] [--unroll U,...]\n"
+			"  [--graphs G,...] [--symmetric 0,1] [--naive] [--json FILE] [--csv FILE]\n", argv[0]);
+		return 2;
+	}
+	if (options.json_path == "-" || options.csv_path == "-") options.log = stderr;
+	std::vector<result_t> results;
+	sweep_type<int64_t >(options, results);
+	sweep_type<int32_t >(options, results);
+	sweep_type<int16_t >(options, results);
+	sweep_type<double  >(options, results);
+	sweep_type<float   >(options, results);
+	sweep_type<uint16_t>(options, results);
+	sweep_type<uint8_t >(options, results);
+
+	bool ok = write(options.json_path, results, write_json) && write(options.csv_path, results, write_csv);
+	if (!ok) fprintf(stderr, "failed to write the results\n");
+	// every solver must give the same result on the same input
+	std::map<std::string, uint32_t> checksums;
+	for (auto &r : results) {
+		const std::string key = r.type + " " + r.graph + " " + std::to_string(r.n) + " " + std::to_string(r.symmetric);
+		if (!checksums.count(key)) checksums[key] = r.checksum;
+		else if (checksums[key] != r.checksum) {
+			fprintf(stderr, "%s : the result differs from the other solvers(%s, symmetric = %d, %s, n = %d)\n",
+				r.solver.c_str(), r.type.c_str(), (int) r.symmetric, r.graph.c_str(), r.n);
+			ok = false;
+		}
+	}
+	return ok ? 0 : 1;
 }
@@ -0,0 +1,165 @@
+#include <cstdio>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include "quick_floyd_warshall/qfw.h"
+#include "utils/utils.h"
+
+using namespace quick_floyd_warshall;
+
+typedef enum {
+	POTENTIAL,            // negative edges but no negative cycle
+	POTENTIAL_WITH_CYCLE, // POTENTIAL with a short negative cycle added
+	RANDOM_SIGNED         // edge weights uniformly distributed in [-W, W]
+} GraphType;
+
+/*
+	textbook Floyd-Warshall in int64_t with explicit checks for unreachability,
+	followed by marking the pairs connected through a vertex with a negative distance to itself
+*/
+template<typename T> struct floyd_warshall_reference {
+	using value_t = T;
+	static constexpr T INF = inf_value<T>();
+	static bool run(int n, const T *input_matrix, T *output_matrix, bool *reaches_negative_cycle) {
+		const int64_t UNREACHABLE = std::numeric_limits<int64_t>::max();
+		const int64_t LOWER_LIMIT = -((int64_t) 1 << 62); // the sum of two of them doesn't overflow
+		std::vector<int64_t> dist(n * n);
+		for (int i = 0; i < n * n; i++) dist[i] = input_matrix[i] == INF ? UNREACHABLE : input_matrix[i];
+		for (int k = 0; k < n; k++) for (int i = 0; i < n; i++) for (int j = 0; j < n; j++)
+			if (dist[i * n + k] != UNREACHABLE && dist[k * n + j] != UNREACHABLE)
+				dist[i * n + j] = std::max(LOWER_LIMIT, std::min(dist[i * n + j], dist[i * n + k] + dist[k * n + j]));
+
+		bool has_negative_cycle = false;
+		std::vector<bool> unbounded(n * n, false);
+		for (int k = 0; k < n; k++) if (dist[k * n + k] < 0) {
+			has_negative_cycle = true;
+			for (int i = 0; i < n; i++) for (int j = 0; j < n; j++)
+				if (dist[i * n + k] != UNREACHABLE && dist[k * n + j] != UNREACHABLE) unbounded[i * n + j] = true;
+		}
+		for (int i = 0; i < n; i++) {
+			reaches_negative_cycle[i] = false;
+			for (int j = 0; j < n; j++) {
+				if (unbounded[i * n + j]) output_matrix[i * n + j] = -INF, reaches_negative_cycle[i] = true;
+				else output_matrix[i * n + j] = dist[i * n + j] == UNREACHABLE ? INF : dist[i * n + j];
+			}
+		}
+		return has_negative_cycle;
+	}
+};
+
+template<typename T> struct Test {
+	using value_t = T;
+	static constexpr value_t INF = floyd_warshall_reference<T>::INF;
+
+	int n;
+	std::vector<value_t> org_matrix;
+	std::vector<value_t> correct_matrix;
+	std::vector<value_t> test_matrix;
+	std::vector<char> correct_reaches;
+	bool correct_has_negative_cycle;
+	Test (Random &random, int n_low, int n_high, GraphType graph_type) {
+		n = random.rnd_int(n_low, n_high);
+		// any simple path must have a total weight with absolute value less than INF / 2
+		value_t W = max_total_weight<value_t>() / 2 / std::max(1, n - 1);
+		// probability of having an edge in 1/1024
+		int density = graph_type == RANDOM_SIGNED ? random.rnd_int(1, 3 * 1024 / n + 1) : random.rnd_int(1, 1024);
+
+		org_matrix.assign(n * n, (value_t) INF); // avoid referencing a constexpr variable
+		std::vector<value_t> potential(n);
+		for (auto &p : potential) p = random.rnd_int(0, W / 2);
+		for (int i = 0; i < n; i++) for (int j = 0; j < n; j++) if (i != j && random.rnd_int(0, 1023) < density) {
+			if (graph_type == RANDOM_SIGNED) org_matrix[i * n + j] = random.rnd_int(-W, W);
+			else org_matrix[i * n + j] = random.rnd_int(0, W / 2) + potential[i] - potential[j];
+		}
+		if (graph_type == POTENTIAL_WITH_CYCLE && n >= 2) {
+			int length = random.rnd_int(2, std::min(n, 4));
+			std::vector<int> perm(n);
+			std::iota(perm.begin(), perm.end(), 0);
+			for (int i = 1; i < n; i++) std::swap(perm[random.rnd_int(0, i)], perm[i]);
+			for (int i = 0; i < length; i++) org_matrix[perm[i] * n + perm[(i + 1) % length]] = i ? 0 : -1;
+		}
+		for (int i = 0; i < n; i++) org_matrix[i * n + i] = 0;
+
+		correct_matrix.resize(n * n);
+		std::unique_ptr<bool[]> reaches(new bool[n + 1]);
+		correct_has_negative_cycle = floyd_warshall_reference<T>::run(n, org_matrix.data(), correct_matrix.data(), reaches.get());
+		correct_reaches.assign(reaches.get(), reaches.get() + n);
+	}
+	template<class TestRunner> bool test() {
+		test_matrix = org_matrix;
+		std::unique_ptr<bool[]> reaches(new bool[n + 1]);
+		bool has_negative_cycle = TestRunner::run_checked(n, test_matrix.data(), test_matrix.data(), reaches.get());
+		if (has_negative_cycle != correct_has_negative_cycle) {
+			printf("\n%s FAILED: negative cycle %s\n", TestRunner::get_description().c_str(),
+				correct_has_negative_cycle ? "not detected" : "falsely detected");
+			return false;
+		}
+		for (int i = 0; i < n; i++) if (reaches[i] != (bool) correct_reaches[i]) {
+			printf("\n%s FAILED: wrong reaches_negative_cycle for vertex %d\n", TestRunner::get_description().c_str(), i);
+			return false;
+		}
+		if (test_matrix != correct_matrix) {
+			int diff_cnt = 0;
+			for (int i = 0; i < n * n; i++) diff_cnt += test_matrix[i] != correct_matrix[i];
+			printf("\n%s FAILED: %d elements differ\n", TestRunner::get_description().c_str(), diff_cnt);
+			for (int i = 0; i < n * n; i++) if (test_matrix[i] != correct_matrix[i]) {
+				printf("  first mismatch at #%d((%d, %d)) : %lld (correct: %lld)\n", i, i / n, i % n,
+					(long long) test_matrix[i], (long long) correct_matrix[i]);
+				break;
+			}
+			return false;
+		}
+		return true;
+	}
+};
+
+template<InstSet inst_set, typename test_t> bool test_all_unroll_types(test_t &test) {
+	if (!test.template test<floyd_warshall<inst_set, typename test_t::value_t, 0> >()) return false;
+	if (!test.template test<floyd_warshall<inst_set, typename test_t::value_t, 1> >()) return false;
+	if (!test.template test<floyd_warshall<inst_set, typename test_t::value_t, 2> >()) return false;
+	if (!test.template test<floyd_warshall<inst_set, typename test_t::value_t, 3> >()) return false;
+	return true;
+}
+template<typename test_t> bool test_all_instruction_sets(test_t &test) {
+	if (!test_all_unroll_types<InstSet::DEFAULT, test_t>(test)) return false;
+	if (!test_all_unroll_types<InstSet::SSE4_2 , test_t>(test)) return false;
+	if (!test_all_unroll_types<InstSet::AVX2   , test_t>(test)) return false;
+	if (vectorize::is_supported(InstSet::AVX512) && !test_all_unroll_types<InstSet::AVX512, test_t>(test)) return false;
+	if (!test.template test<floyd_warshall<InstSet::AVX2, typename test_t::value_t, 3, 32> >()) return false;
+	if (!test.template test<floyd_warshall_dispatch<typename test_t::value_t> >()) return false;
+	return true;
+}
+
+template<typename T> bool test_all_multiple(Random &random, int n_low, int n_high, int n_tests, GraphType graph_type) {
+	printf("  Test n:[%d, %d] x%d ", n_low, n_high, n_tests);
+
+	int n_with_cycle = 0;
+	for (int t = 0; t < n_tests; t++) {
+		Test<T> test(random, n_low, n_high, graph_type);
+		if (!test_all_instruction_sets<>(test)) return false;
+		n_with_cycle += test.correct_has_negative_cycle;
+	}
+	printf("OK (%d with negative cycles)\n", n_with_cycle);
+	return true;
+}
+template<typename T> bool test_all_with_standard_parameters(Random &random, GraphType graph_type) {
+	printf("Testing %s...\n", vectorize::type_to_str<T>().c_str());
+	return
+		test_all_multiple<T>(random, 200, 300, 2 , graph_type) &&
+		test_all_multiple<T>(random, 32, 200, 20 , graph_type) &&
+		test_all_multiple<T>(random, 1, 32, 300  , graph_type);
+}
+
+int main() {
+	printf("Running on %s\n", vectorize::inst_set_to_str(vectorize::best_inst_set()).c_str());
+	Random random;
+	for (GraphType graph_type : { POTENTIAL, POTENTIAL_WITH_CYCLE, RANDOM_SIGNED }) {
+		if (!test_all_with_standard_parameters<int64_t>(random, graph_type)) return 1;
+		if (!test_all_with_standard_parameters<int32_t>(random, graph_type)) return 1;
+		if (!test_all_with_standard_parameters<int16_t>(random, graph_type)) return 1;
+		if (!test_all_with_standard_parameters<double >(random, graph_type)) return 1;
+		if (!test_all_with_standard_parameters<float  >(random, graph_type)) return 1;
+	}
+	return 0;
+}
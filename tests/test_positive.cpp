@@ -3,16 +3,12 @@
 #include <vector>
 #include <algorithm>
 #include <numeric>
+#include <thread>
 #include "quick_floyd_warshall/qfw.h"
-#include "utils/utils.h"
+#include "utils/graphs.h"
 
 using namespace quick_floyd_warshall;
 
-typedef enum {
-	RANDOM_DENSE,
-	RANDOM_PATH,
-	MAX_PATH
-} GraphType;
 template<class CorrectRunner> struct Test {
 	using value_t = typename CorrectRunner::value_t;
 	static constexpr value_t INF = CorrectRunner::INF;
@@ -25,27 +21,7 @@ template<class CorrectRunner> struct Test {
 	Test (Random &random, int n_low, int n_high, bool symmetric, GraphType graph_type) {
 		n = random.rnd_int(n_low, n_high);
 		this->symmetric = symmetric;
-		value_t MAX_UNIFORM_WEIGHT = (INF - 1) / std::max(1, n - 1);
-		if (graph_type == GraphType::RANDOM_DENSE) {
-			org_matrix.assign(n * n, 0);
-			if (symmetric) {
-				for (int i = 0; i < n; i++) for (int j = 0; j < i; j++)
-					org_matrix[i * n + j] = org_matrix[j * n + i] = random.rnd_int(1, MAX_UNIFORM_WEIGHT);
-			} else {
-				for (int i = 0; i < n; i++) for (int j = 0; j < n; j++)
-					org_matrix[i * n + j] = random.rnd_int(1, MAX_UNIFORM_WEIGHT);
-			}
-		} else if (graph_type == GraphType::RANDOM_PATH || graph_type == GraphType::MAX_PATH) {
-			org_matrix.assign(n * n, (value_t) INF); // avoid referencing a constexpr variable
-			std::vector<int> perm(n);
-			std::iota(perm.begin(), perm.end(), 0);
-			for (int i = 1; i < n; i++) std::swap(perm[random.rnd_int(0, i)], perm[i]);
-			for (int i = 0; i + 1 < n; i++) {
-				org_matrix[perm[i] * n + perm[i + 1]] = graph_type == GraphType::RANDOM_PATH ?
-					random.rnd_int(1, MAX_UNIFORM_WEIGHT) : MAX_UNIFORM_WEIGHT;
-				if (symmetric) org_matrix[perm[i + 1] * n + perm[i]] = org_matrix[perm[i] * n + perm[i + 1]];
-			}
-		}
+		org_matrix = generate_graph<value_t>(random, n, symmetric, graph_type, INF);
 		
 		correct_matrix = org_matrix;
 		CorrectRunner::run(n, correct_matrix.data(), correct_matrix.data(), symmetric);
@@ -66,6 +42,256 @@ template<class CorrectRunner> struct Test {
 			return false;
 		} else return true;
 	}
+	// checks that the reachability is where the distances are less than INF(except for the unsigned types, whose distances saturate at INF)
+	template<class Solver> bool test_closure() {
+		if (std::is_unsigned<value_t>::value) return true;
+		const size_t n_elements = (size_t) n * n;
+		std::unique_ptr<bool[]> edges(new bool[n_elements]), reachable(new bool[n_elements]);
+		for (size_t i = 0; i < n_elements; i++) edges[i] = org_matrix[i] < INF;
+		Solver::run(n, edges.get(), reachable.get());
+		/*
+			a cycle may have n edges and its length may exceed INF, so the diagonal is checked by the cycles instead:
+			i reaches itself iff it has a loop or reaches a vertex having an edge to i
+		*/
+		for (int i = 0; i < n; i++) for (int j = 0; j < n; j++) {
+			bool expected = i != j ? correct_matrix[(size_t) i * n + j] < INF : edges[(size_t) i * n + i];
+			for (int k = 0; i == j && k < n && !expected; k++) expected = k != i && reachable[(size_t) i * n + k] && edges[(size_t) k * n + i];
+			if (reachable[(size_t) i * n + j] != expected) {
+				printf("\n%s FAILED: reachability differs at (%d, %d)\n", Solver::get_description().c_str(), i, j);
+				return false;
+			}
+		}
+		return true;
+	}
+	// checks the distances and that the restored paths are valid and as short as the distances
+	template<class TestRunner, typename index_t> bool test_path(Random &random) {
+		test_matrix = org_matrix;
+		std::vector<index_t> next_matrix(n * n);
+		TestRunner::run(n, test_matrix.data(), test_matrix.data(), next_matrix.data());
+		if (test_matrix != correct_matrix) {
+			printf("\n%s FAILED: distances differ when restoring paths\n", TestRunner::get_description().c_str());
+			return false;
+		}
+		// u == v is not checked because the test graphs may have non-zero diagonal elements
+		for (int t = 0; n > 1 && t < 8 * n; t++) {
+			int u = random.rnd_int(0, n - 1);
+			int v = (u + random.rnd_int(1, n - 1)) % n;
+			std::vector<int> path = get_path(n, next_matrix.data(), u, v);
+			bool ok;
+			if (correct_matrix[u * n + v] == INF) ok = path.empty();
+			else {
+				value_t length = 0;
+				ok = path.size() >= 1 && (int) path.size() <= n && path.front() == u && path.back() == v;
+				for (int i = 0; ok && i + 1 < (int) path.size(); i++) {
+					ok = org_matrix[path[i] * n + path[i + 1]] < INF;
+					length += org_matrix[path[i] * n + path[i + 1]];
+				}
+				ok = ok && length == correct_matrix[u * n + v];
+			}
+			if (!ok) {
+				printf("\n%s FAILED: invalid path from %d to %d\n", TestRunner::get_description().c_str(), u, v);
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+// runs parallel_floyd_warshall with more threads than the hardware may have, so that the scheduling is always exercised
+template<InstSet inst_set, typename T, int unroll_type> struct parallel_test_runner : parallel_floyd_warshall<inst_set, T, unroll_type> {
+	static void run(int n, const T *input_matrix, T *output_matrix, bool symmetric) {
+		parallel_floyd_warshall<inst_set, T, unroll_type>::run(n, input_matrix, output_matrix, symmetric, 4);
+	}
+};
+
+// solves in a blocked_matrix filled with set() and read back with the row iterators
+template<InstSet inst_set, typename T, int unroll_type, int block_size> struct blocked_test_runner : floyd_warshall<inst_set, T, unroll_type, block_size> {
+	static std::string get_description() { return "blocked_" + floyd_warshall<inst_set, T, unroll_type, block_size>::get_description(); }
+	static void run(int n, const T *input_matrix, T *output_matrix, bool symmetric) {
+		blocked_matrix<T, block_size> matrix(n);
+		for (int i = 0; i < n; i++) for (int j = 0; j < n; j++) matrix.set(i, j, input_matrix[i * n + j]);
+		blocked_matrix<T, block_size> copied = matrix;
+		floyd_warshall<inst_set, T, unroll_type, block_size>::run(copied, symmetric);
+		matrix = std::move(copied);
+		for (int i = 0; i < n; i++) std::copy(matrix.row(i).begin(), matrix.row(i).end(), output_matrix + i * n);
+	}
+};
+
+// solves in a blocked_matrix, writes it to a distance_file and reads the distances back with read_row() and distance()
+template<InstSet inst_set, typename T, int unroll_type, bool compressed> struct distance_file_test_runner : floyd_warshall<inst_set, T, unroll_type> {
+	static std::string get_description() {
+		return std::string(compressed ? "compressed_" : "") + "distance_file_" + floyd_warshall<inst_set, T, unroll_type>::get_description();
+	}
+	static void run(int n, const T *input_matrix, T *output_matrix, bool symmetric) {
+		const std::string path = "/tmp/quick_floyd_warshall_test_distance_file.bin";
+		blocked_matrix<T> matrix(n, input_matrix);
+		floyd_warshall<inst_set, T, unroll_type>::run(matrix, symmetric);
+		distance_file<T> file;
+		if (!distance_file<T>::write(path, matrix, symmetric, compressed) || !file.open(path) || file.size() != n) {
+			printf("\nfailed to write or open %s\n", path.c_str());
+			return;
+		}
+		for (int i = 0; i < n; i++) {
+			if (i % 2) for (int j = 0; j < n; j++) output_matrix[i * n + j] = file.distance(i, j);
+			else file.read_row(i, output_matrix + i * n);
+		}
+		file.close();
+		remove(path.c_str());
+	}
+};
+// solves in a file-mapped blocked_matrix with a memory budget small enough to split it into several super-tiles
+template<InstSet inst_set, typename T, int unroll_type> struct out_of_core_test_runner : out_of_core_floyd_warshall<inst_set, T, unroll_type, 64> {
+	static void run(int n, const T *input_matrix, T *output_matrix, bool) {
+		const std::string path = "/tmp/quick_floyd_warshall_test_out_of_core.bin";
+		blocked_matrix<T> matrix;
+		if (!matrix.map_file(path, n, true)) {
+			printf("\nfailed to map %s\n", path.c_str());
+			return;
+		}
+		for (int i = 0; i < n; i++) for (int j = 0; j < n; j++) matrix.set(i, j, input_matrix[i * n + j]);
+		out_of_core_floyd_warshall<inst_set, T, unroll_type, 64>::run(matrix, 6 * 64 * 64 * sizeof(T));
+		matrix.to_matrix(output_matrix);
+		matrix = blocked_matrix<T>();
+		remove(path.c_str());
+	}
+};
+
+template<InstSet inst_set, typename T, int unroll_type> struct sparse_test_runner : floyd_warshall<inst_set, T, unroll_type> {
+	static std::string get_description() { return "sparse_" + floyd_warshall<inst_set, T, unroll_type>::get_description(); }
+	static void run(int n, const T *input_matrix, T *output_matrix, bool symmetric) {
+		floyd_warshall<inst_set, T, unroll_type>::run_sparse(n, input_matrix, output_matrix, symmetric);
+	}
+};
+
+/*
+	solves a graph made of two copies of the input graph with the vertices interleaved(vertex v of copy c is 2 * v + c) and an isolated vertex,
+	so that run_components has at least three components that are not contiguous, and checks that the copies don't reach each other.
+	parallel_floyd_warshall::run_components is run with 4 threads like parallel_test_runner
+*/
+template<class Solver, bool parallel> struct components_test_runner : Solver {
+	using T = typename Solver::value_t;
+	static std::string get_description() { return "components_" + Solver::get_description(); }
+	static void run(int n, const T *input_matrix, T *output_matrix, bool symmetric) {
+		const int N = 2 * n + 1;
+		std::vector<T> matrix((size_t) N * N, (T) Solver::INF); // avoid referencing a constexpr variable
+		for (int c = 0; c < 2; c++) for (int i = 0; i < n; i++) for (int j = 0; j < n; j++)
+			matrix[(2 * i + c) * N + 2 * j + c] = input_matrix[i * n + j];
+		matrix[(N - 1) * N + N - 1] = 0;
+		run_components(N, matrix.data(), symmetric, std::integral_constant<bool, parallel>());
+		for (int i = 0; i < N; i++) for (int j = 0; j < N; j++) {
+			bool connected = i == j || (i % 2 == j % 2 && i != N - 1 && j != N - 1);
+			if (connected ? matrix[i * N + j] != matrix[(i / 2 * 2) * N + j / 2 * 2] : matrix[i * N + j] != (T) Solver::INF) {
+				printf("\n%s FAILED: wrong result at (%d, %d) of the copies\n", get_description().c_str(), i, j);
+				exit(1);
+			}
+		}
+		for (int i = 0; i < n; i++) for (int j = 0; j < n; j++) output_matrix[i * n + j] = matrix[(2 * i) * N + 2 * j];
+	}
+	static void run_components(int N, T *matrix, bool symmetric, std::false_type) { Solver::run_components(N, matrix, matrix, symmetric); }
+	static void run_components(int N, T *matrix, bool symmetric, std::true_type) { Solver::run_components(N, matrix, matrix, symmetric, 4); }
+};
+
+// solves the graph with an observer checking the progress and the counts of FWI calls,
+// and then with one cancelling it after REORDER, which must leave the output untouched
+template<class Solver, bool parallel> struct observed_test_runner : Solver {
+	using T = typename Solver::value_t;
+	struct progress_observer : observe::observer {
+		size_t done = 0, total = 0;
+		bool monotonic = true;
+		bool cancel_after_reorder = false;
+		void on_phase(observe::phase_t phase, double) override { if (cancel_after_reorder && phase == observe::phase_t::REORDER) cancel(); }
+		void on_progress(size_t done, size_t total) override {
+			monotonic = monotonic && done >= this->done && done <= total;
+			this->done = done;
+			this->total = total;
+		}
+	};
+	static std::string get_description() { return "observed_" + Solver::get_description(); }
+	static void run(int n, const T *input_matrix, T *output_matrix, bool symmetric) {
+		progress_observer observer;
+		bool completed = run_observed(n, input_matrix, output_matrix, symmetric, observer, std::integral_constant<bool, parallel>());
+		if (!completed || !observer.monotonic || (n && (observer.done != observer.total ||
+			observer.stats.fwi_calls + observer.stats.fwi_skipped != observer.total))) {
+			printf("\n%s FAILED: wrong progress %zu / %zu(%zu calls, %zu skipped)\n", get_description().c_str(),
+				observer.done, observer.total, observer.stats.fwi_calls, observer.stats.fwi_skipped);
+			exit(1);
+		}
+		progress_observer cancelling;
+		cancelling.cancel_after_reorder = true;
+		std::vector<T> untouched(output_matrix, output_matrix + (size_t) n * n);
+		if (run_observed(n, input_matrix, untouched.data(), symmetric, cancelling, std::integral_constant<bool, parallel>()) ||
+			!cancelling.stats.cancelled || !std::equal(untouched.begin(), untouched.end(), output_matrix)) {
+			printf("\n%s FAILED: not cancelled\n", get_description().c_str());
+			exit(1);
+		}
+	}
+	static bool run_observed(int n, const T *input_matrix, T *output_matrix, bool symmetric, observe::observer &observer, std::false_type) {
+		return Solver::run(n, input_matrix, output_matrix, symmetric, observer);
+	}
+	static bool run_observed(int n, const T *input_matrix, T *output_matrix, bool symmetric, observe::observer &observer, std::true_type) {
+		return Solver::run(n, input_matrix, output_matrix, symmetric, 4, observer);
+	}
+};
+
+// solves every graph with the same solver, whose workspace grows and is reused with the stale content of the previous graphs
+template<class Solver> struct reusable_test_runner : Solver {
+	using T = typename Solver::value_t;
+	static void run(int n, const T *input_matrix, T *output_matrix, bool symmetric) {
+		static Solver solver;
+		solver.run(n, input_matrix, output_matrix, symmetric);
+	}
+};
+
+// solves the graph with ranks as threads: 4(2 x 2) over a loopback_hub for odd n, 3(1 x 3) over socket pairs for even n
+template<InstSet inst_set, typename T, int unroll_type> struct distributed_test_runner : distributed_floyd_warshall<inst_set, T, unroll_type> {
+	using base = distributed_floyd_warshall<inst_set, T, unroll_type>;
+	static void run(int n, const T *input_matrix, T *output_matrix, bool) {
+		const std::vector<T> input(input_matrix, input_matrix + (size_t) n * n); // input_matrix may be output_matrix
+		std::vector<std::unique_ptr<distributed::transport> > transports;
+		distributed::loopback_hub hub(4);
+		if (n % 2) for (int rank = 0; rank < 4; rank++) transports.push_back(hub.connect(rank));
+		else {
+			std::vector<std::vector<int> > fds = distributed::socket_transport::connect_local(3);
+			for (int rank = 0; rank < (int) fds.size(); rank++) transports.emplace_back(new distributed::socket_transport(rank, fds[rank]));
+		}
+		std::vector<std::thread> threads;
+		std::vector<char> ok(transports.size());
+		for (int rank = 0; rank < (int) transports.size(); rank++) threads.emplace_back([&, rank] () {
+			ok[rank] = base::run(*transports[rank], n, input.data(), rank == 0 ? output_matrix : nullptr);
+		});
+		for (auto &thread : threads) thread.join();
+		if (transports.empty() || std::count(ok.begin(), ok.end(), 0)) {
+			printf("\n%s FAILED: transport failed\n", base::get_description().c_str());
+			exit(1);
+		}
+	}
+};
+
+// solves the graph as two of the count = lanes + 1 graphs of run_batch(one in each interleaved group) among empty graphs,
+// which must not be affected by the other lanes
+template<InstSet inst_set, typename T> struct batch_test_runner : floyd_warshall<inst_set, T, 0> {
+	static std::string get_description() { return "batch_" + floyd_warshall<inst_set, T, 0>::get_description(); }
+	static void run(int n, const T *input_matrix, T *output_matrix, bool) {
+		const int count = vectorize::vector_t<inst_set, T>::SIZE / sizeof(T) + 1;
+		const size_t n_elements = (size_t) n * n;
+		std::vector<T> empty(n_elements, (T) floyd_warshall<inst_set, T, 0>::INF); // avoid referencing a constexpr variable
+		for (int i = 0; i < n; i++) empty[i * n + i] = 0;
+		std::vector<T> matrices;
+		for (int g = 0; g < count; g++) {
+			const T *graph = g == 1 || g == count - 1 ? input_matrix : empty.data();
+			matrices.insert(matrices.end(), graph, graph + n_elements);
+		}
+		floyd_warshall<inst_set, T, 0>::run_batch(count, n, matrices.data(), matrices.data());
+		for (int g = 0; g < count; g++) if (g != 1 && g != count - 1 && !std::equal(empty.begin(), empty.end(), &matrices[g * n_elements])) {
+			printf("\n%s FAILED: graph #%d affected by the other graphs\n", get_description().c_str(), g);
+			exit(1);
+		}
+		if (!std::equal(&matrices[n_elements], &matrices[2 * n_elements], &matrices[(count - 1) * n_elements])) {
+			printf("\n%s FAILED: results differ between the groups\n", get_description().c_str());
+			exit(1);
+		}
+		std::copy(&matrices[n_elements], &matrices[2 * n_elements], output_matrix);
+	}
 };
 
 template<InstSet inst_set, typename test_t> bool test_all_unroll_types(test_t &test) {
@@ -75,10 +301,118 @@ template<InstSet inst_set, typename test_t> bool test_all_unroll_types(test_t &t
 	if (!test.template test<floyd_warshall<inst_set, typename test_t::value_t, 3> >()) return false;
 	return true;
 }
+template<typename test_t> bool test_all_paths(Random &random, test_t &test) {
+	using value_t = typename test_t::value_t;
+	if (!test.template test_path<floyd_warshall<InstSet::DEFAULT, value_t, 0>, int32_t>(random)) return false;
+	if (!test.template test_path<floyd_warshall<InstSet::AVX2   , value_t, 3>, int32_t>(random)) return false;
+	if (!test.template test_path<floyd_warshall<InstSet::AVX2   , value_t, 3>, int16_t>(random)) return false;
+	if (vectorize::is_supported(InstSet::AVX512) &&
+		!test.template test_path<floyd_warshall<InstSet::AVX512, value_t, 3>, int16_t>(random)) return false;
+	return true;
+}
 template<typename test_t> bool test_all_instruction_sets(test_t &test) {
 	if (!test_all_unroll_types<InstSet::DEFAULT, test_t>(test)) return false;
 	if (!test_all_unroll_types<InstSet::SSE4_2 , test_t>(test)) return false;
 	if (!test_all_unroll_types<InstSet::AVX2   , test_t>(test)) return false;
+	if (vectorize::is_supported(InstSet::AVX512) && !test_all_unroll_types<InstSet::AVX512, test_t>(test)) return false;
+	if (!test.template test<floyd_warshall<InstSet::AVX2, typename test_t::value_t, 3, 32> >()) return false;
+	if (!test.template test<floyd_warshall<InstSet::AVX2, typename test_t::value_t, 1, 128> >()) return false;
+	if (!test.template test<parallel_test_runner<InstSet::AVX2, typename test_t::value_t, 3> >()) return false;
+	if (!test.template test<blocked_test_runner<InstSet::AVX2, typename test_t::value_t, 3, 64> >()) return false;
+	if (!test.template test<out_of_core_test_runner<InstSet::AVX2, typename test_t::value_t, 3> >()) return false;
+	if (!test.template test<distance_file_test_runner<InstSet::AVX2, typename test_t::value_t, 3, false> >()) return false;
+	if (!test.template test<distance_file_test_runner<InstSet::AVX2, typename test_t::value_t, 3, true> >()) return false;
+	if (!test.template test<sparse_test_runner<InstSet::AVX2, typename test_t::value_t, 3> >()) return false;
+	if (!test.template test<components_test_runner<floyd_warshall<InstSet::AVX2, typename test_t::value_t, 3>, false> >()) return false;
+	if (!test.template test<components_test_runner<parallel_floyd_warshall<InstSet::AVX2, typename test_t::value_t, 3>, true> >()) return false;
+	if (!test.template test<observed_test_runner<floyd_warshall<InstSet::AVX2, typename test_t::value_t, 3>, false> >()) return false;
+	if (!test.template test<observed_test_runner<parallel_floyd_warshall<InstSet::AVX2, typename test_t::value_t, 3>, true> >()) return false;
+	if (!test.template test<reusable_test_runner<reusable_floyd_warshall<InstSet::AVX2, typename test_t::value_t, 3> > >()) return false;
+	if (!test.template test<distributed_test_runner<InstSet::AVX2, typename test_t::value_t, 3> >()) return false;
+	if (!test.template test_closure<transitive_closure<InstSet::DEFAULT, 64> >()) return false;
+	if (!test.template test_closure<transitive_closure<InstSet::SSE4_2, 128> >()) return false;
+	if (!test.template test_closure<transitive_closure<InstSet::AVX2, 512> >()) return false;
+	if (vectorize::is_supported(InstSet::AVX512) && !test.template test_closure<transitive_closure<InstSet::AVX512, 1024> >()) return false;
+	if (!test.template test<batch_test_runner<InstSet::DEFAULT, typename test_t::value_t> >()) return false;
+	if (!test.template test<batch_test_runner<InstSet::AVX2, typename test_t::value_t> >()) return false;
+	if (vectorize::is_supported(InstSet::AVX512) &&
+		!test.template test<batch_test_runner<InstSet::AVX512, typename test_t::value_t> >()) return false;
+	if (!test.template test<floyd_warshall_dispatch<typename test_t::value_t> >()) return false;
+	if (!test.template test<adaptive_floyd_warshall<typename test_t::value_t> >()) return false;
+	return true;
+}
+
+/*
+	builds a random graph by adding the vertices one by one to a solved subgraph and decreasing random edges afterwards,
+	and compares the distances with the naive solver.
+	With negative, the weights are c + p[u] - p[v] for c >= 0 and random potentials p, so that there is no negative cycle,
+	and a cycle through all the vertices is added last, so that the distances compared are all finite
+	(those of the unreachable pairs are INF minus some weights, which depend on the order of the updates)
+*/
+template<class IncrementalRunner> bool test_incremental(Random &random, int n, bool negative) {
+	using value_t = typename IncrementalRunner::value_t;
+	const value_t INF = IncrementalRunner::INF;
+	const value_t MAX_UNIFORM_WEIGHT = max_total_weight<value_t>() / std::max(1, n - 1);
+	std::vector<value_t> potentials(n, 0);
+	if (negative) for (auto &potential : potentials) potential = random.rnd_int(0, MAX_UNIFORM_WEIGHT / 4);
+	auto random_weight = [&] (int u, int v, value_t max_weight) {
+		return (value_t) (random.rnd_int(u == v ? 0 : !negative, max_weight) + potentials[u] - potentials[v]);
+	};
+	const int density = random.rnd_int(1, 1024); // probability of having an edge in 1/1024
+	std::vector<value_t> matrix(n * n, INF);
+	for (int i = 0; i < n; i++) for (int j = 0; j < n; j++) if (i == j) matrix[i * n + j] = 0;
+		else if (random.rnd_int(0, 1023) < density) matrix[i * n + j] = random_weight(i, j, negative ? MAX_UNIFORM_WEIGHT / 2 : MAX_UNIFORM_WEIGHT);
+	
+	int n_initial = random.rnd_int(0, n);
+	std::vector<value_t> initial_matrix(n_initial * n_initial);
+	for (int i = 0; i < n_initial; i++) for (int j = 0; j < n_initial; j++) initial_matrix[i * n_initial + j] = matrix[i * n + j];
+	IncrementalRunner solver(n_initial, initial_matrix.data());
+	bool ok = true;
+	for (int v = n_initial; v < n; v++) {
+		std::vector<value_t> out_weights(matrix.begin() + v * n, matrix.begin() + v * n + v), in_weights(v);
+		for (int i = 0; i < v; i++) in_weights[i] = matrix[i * n + v];
+		ok = ok && solver.add_vertex(out_weights.data(), in_weights.data());
+	}
+	std::vector<typename IncrementalRunner::edge_t> edges;
+	for (int t = 0; n > 0 && t < 8; t++) {
+		int u = random.rnd_int(0, n - 1), v = random.rnd_int(0, n - 1);
+		value_t weight = random_weight(u, v, MAX_UNIFORM_WEIGHT / 4);
+		matrix[u * n + v] = std::min(matrix[u * n + v], weight);
+		if (t % 2) ok = ok && solver.decrease_edge(u, v, weight);
+		else edges.push_back({ u, v, weight });
+	}
+	ok = ok && solver.decrease_edges(edges.data(), edges.size());
+	for (int u = 0; negative && u < n; u++) {
+		int v = (u + 1) % n;
+		value_t weight = random_weight(u, v, MAX_UNIFORM_WEIGHT / 4);
+		matrix[u * n + v] = std::min(matrix[u * n + v], weight);
+		ok = ok && solver.decrease_edge(u, v, weight);
+	}
+	if (!ok) {
+		printf("\n%s FAILED: an update was rejected\n", IncrementalRunner::get_description().c_str());
+		return false;
+	}
+	
+	std::vector<value_t> correct_matrix(n * n), test_matrix(n * n);
+	floyd_warshall_naive<value_t>::run(n, matrix.data(), correct_matrix.data());
+	solver.get_matrix(test_matrix.data());
+	if (solver.size() != n || test_matrix != correct_matrix) {
+		printf("\n%s FAILED: distances differ after the updates\n", IncrementalRunner::get_description().c_str());
+		return false;
+	}
+	return true;
+}
+template<typename T> bool test_all_incremental(Random &random) {
+	printf("Testing incremental updates with %s... ", vectorize::type_to_str<T>().c_str());
+	for (int t = 0; t < 200; t++) {
+		int n = t < 190 ? random.rnd_int(0, 70) : random.rnd_int(100, 300);
+		bool negative = t % 2;
+		if (!test_incremental<incremental_floyd_warshall<InstSet::DEFAULT, T, 0> >(random, n, negative)) return false;
+		if (!test_incremental<incremental_floyd_warshall<InstSet::AVX2, T, 3, 32> >(random, n, negative)) return false;
+		if (vectorize::is_supported(InstSet::AVX512) &&
+			!test_incremental<incremental_floyd_warshall<InstSet::AVX512, T, 3> >(random, n, negative)) return false;
+	}
+	puts("OK");
 	return true;
 }
 
@@ -93,7 +427,7 @@ template<typename T> bool test_all_multiple(Random &random, int n_low, int n_hig
 	const int pass_cnt_interval = std::max(1, n_tests / 100);
 	for (int t = 0; t < n_tests; t++) {
 		Test<floyd_warshall_naive<T> > test(random, n_low, n_high, symmetric, graph_type);
-		if (!test_all_instruction_sets<>(test)) {
+		if (!test_all_instruction_sets<>(test) || (!symmetric && !test_all_paths<>(random, test))) {
 			res = false;
 			break;
 		}
@@ -110,7 +444,7 @@ template<typename T> bool test_all_multiple(Random &random, int n_low, int n_hig
 	return res;
 }
 template<typename T> bool test_all_with_standard_parameters(Random &random, bool symmetric, GraphType graph_type) {
-	printf("Testing int%d_t...\n", (int) (sizeof(T) * 8));
+	printf("Testing %s...\n", vectorize::type_to_str<T>().c_str());
 	return 
 		test_all_multiple<T>(random, 500, 600, 1 , symmetric, graph_type) &&
 		test_all_multiple<T>(random, 200, 500, 4 , symmetric, graph_type) &&
@@ -119,20 +453,199 @@ template<typename T> bool test_all_with_standard_parameters(Random &random, bool
 		test_all_multiple<T>(random, 1, 32, 1000 , symmetric, graph_type);
 }
 
+/*
+	multiplies random rectangular matrices with INF elements, accumulating into a random c,
+	and compares the result with the triple loop
+*/
+template<class Solver> bool test_min_plus_multiply(Random &random, int m, int n, int k) {
+	using value_t = typename Solver::value_t;
+	const value_t INF = Solver::INF;
+	// the sums saturate at INF with unsigned types
+	const value_t MAX_WEIGHT = std::is_unsigned<value_t>::value ? INF / 2 : max_total_weight<value_t>() / 2;
+	auto random_matrix = [&] (int n_elements) -> std::vector<value_t> {
+		const int density = random.rnd_int(0, 1024); // probability of being finite in 1/1024
+		std::vector<value_t> res(n_elements);
+		for (auto &x : res) x = random.rnd_int(0, 1023) < density ? random.rnd_int(0, MAX_WEIGHT) : INF;
+		return res;
+	};
+	std::vector<value_t> a = random_matrix(m * k), b = random_matrix(k * n), c = random_matrix(m * n);
+	std::vector<value_t> correct_c = c;
+	for (int i = 0; i < m; i++) for (int l = 0; l < k; l++) for (int j = 0; j < n; j++) {
+		value_t sum = std::is_unsigned<value_t>::value && a[i * k + l] > INF - b[l * n + j] ? INF : value_t(a[i * k + l] + b[l * n + j]);
+		correct_c[i * n + j] = std::min(correct_c[i * n + j], sum);
+	}
+	Solver::min_plus_multiply(m, n, k, a.data(), b.data(), c.data());
+	if (c != correct_c) {
+		printf("\n%s FAILED: min_plus_multiply(%d, %d, %d) differs\n", Solver::get_description().c_str(), m, n, k);
+		return false;
+	}
+	return true;
+}
+template<typename T> bool test_all_min_plus_multiply(Random &random) {
+	printf("Testing min_plus_multiply with %s... ", vectorize::type_to_str<T>().c_str());
+	for (int t = 0; t < 100; t++) {
+		int max_size = t < 90 ? 70 : 200;
+		int m = random.rnd_int(0, max_size), n = random.rnd_int(0, max_size), k = random.rnd_int(0, max_size);
+		if (!test_min_plus_multiply<floyd_warshall<InstSet::DEFAULT, T, 0> >(random, m, n, k)) return false;
+		if (!test_min_plus_multiply<floyd_warshall<InstSet::SSE4_2, T, 1> >(random, m, n, k)) return false;
+		if (!test_min_plus_multiply<floyd_warshall<InstSet::AVX2, T, 2, 32> >(random, m, n, k)) return false;
+		if (!test_min_plus_multiply<floyd_warshall<InstSet::AVX2, T, 3, 128> >(random, m, n, k)) return false;
+		if (vectorize::is_supported(InstSet::AVX512) &&
+			!test_min_plus_multiply<floyd_warshall<InstSet::AVX512, T, 3> >(random, m, n, k)) return false;
+		if (!test_min_plus_multiply<floyd_warshall_dispatch<T> >(random, m, n, k)) return false;
+	}
+	puts("OK");
+	return true;
+}
+
+/*
+	solves random graphs with INF(or -INF / 0 for max_min) elements with Semiring,
+	symmetric or not, and compares the result with the textbook algorithm
+*/
+template<class Solver, class Semiring> bool test_semiring(Random &random, int n, bool symmetric) {
+	using value_t = typename Solver::value_t;
+	const bool widest = std::is_same<Semiring, semiring::max_min>::value;
+	const value_t none = widest ? blocked_matrix<value_t>::encode(Solver::INF) : Solver::INF;
+	const int density = random.rnd_int(0, 1024); // probability of being an edge in 1/1024
+	std::vector<value_t> matrix((size_t) n * n);
+	for (int i = 0; i < n; i++) for (int j = symmetric ? i : 0; j < n; j++) {
+		matrix[i * n + j] = random.rnd_int(0, 1023) < density ? random.rnd_int(0, 100) : none;
+		if (symmetric) matrix[j * n + i] = matrix[i * n + j];
+	}
+	std::vector<value_t> correct = matrix;
+	for (int k = 0; k < n; k++) for (int i = 0; i < n; i++) for (int j = 0; j < n; j++) {
+		if (widest) correct[i * n + j] = std::max(correct[i * n + j], std::min(correct[i * n + k], correct[k * n + j]));
+		else correct[i * n + j] = std::min(correct[i * n + j], std::max(correct[i * n + k], correct[k * n + j]));
+	}
+	Solver::run(n, matrix.data(), matrix.data(), symmetric);
+	if (matrix != correct) {
+		printf("\n%s FAILED: n = %d%s\n", Solver::get_description().c_str(), n, symmetric ? " symmetric" : "");
+		return false;
+	}
+	return true;
+}
+template<typename T, class Semiring> bool test_all_semiring(Random &random) {
+	printf("Testing %s with %s... ", Semiring::name().c_str(), vectorize::type_to_str<T>().c_str());
+	for (int t = 0; t < 100; t++) {
+		const int n = random.rnd_int(1, t < 90 ? 70 : 300);
+		const bool symmetric = random.rnd_int(0, 1);
+		if (!test_semiring<floyd_warshall<InstSet::DEFAULT, T, 0, 64, Semiring>, Semiring>(random, n, symmetric)) return false;
+		if (!test_semiring<floyd_warshall<InstSet::SSE4_2, T, 1, 64, Semiring>, Semiring>(random, n, symmetric)) return false;
+		if (!test_semiring<floyd_warshall<InstSet::AVX2, T, 2, 32, Semiring>, Semiring>(random, n, symmetric)) return false;
+		if (!test_semiring<floyd_warshall<InstSet::AVX2, T, 3, 64, Semiring>, Semiring>(random, n, symmetric)) return false;
+		if (vectorize::is_supported(InstSet::AVX512) &&
+			!test_semiring<floyd_warshall<InstSet::AVX512, T, 3, 64, Semiring>, Semiring>(random, n, symmetric)) return false;
+	}
+	puts("OK");
+	return true;
+}
+template<typename T> bool test_all_semirings(Random &random) {
+	return test_all_semiring<T, semiring::min_max>(random) && test_all_semiring<T, semiring::max_min>(random);
+}
+
+/*
+	solves random graphs with small weights(dense or a single long path) with adaptive_floyd_warshall and compares the result with the naive solver.
+	With negative, the weights are c + p[i] - p[j] for c >= 0 and random potentials p, so that there is no negative cycle
+*/
+template<typename T> bool test_adaptive(Random &random, int n, bool negative, bool symmetric) {
+	const T INF = adaptive_floyd_warshall<T>::INF;
+	const int64_t MAX_WEIGHTS[4] = { 2, 200, 20000, 2000000 };
+	const int64_t max_weight = MAX_WEIGHTS[random.rnd_int(0, 3)];
+	const bool path = random.rnd_int(0, 3) == 0;
+	const int density = random.rnd_int(0, 1024); // probability of having an edge in 1/1024
+	std::vector<int64_t> potentials(n);
+	for (auto &potential : potentials) potential = negative ? random.rnd_int(0, max_weight / 2) : 0;
+	std::vector<T> matrix((size_t) n * n, INF);
+	for (int i = 0; i < n; i++) for (int j = symmetric ? i : 0; j < n; j++) {
+		if (path ? j != i + 1 : random.rnd_int(0, 1023) >= density) continue;
+		T weight = random.rnd_int(0, max_weight / 2) + (i == j ? 0 : potentials[i] - potentials[j]);
+		matrix[(size_t) i * n + j] = weight;
+		if (symmetric) matrix[(size_t) j * n + i] = weight;
+	}
+	std::vector<T> correct_matrix((size_t) n * n), test_matrix((size_t) n * n);
+	floyd_warshall_naive<T>::run(n, matrix.data(), correct_matrix.data());
+	const int value_bytes = adaptive_floyd_warshall<T>::run(n, matrix.data(), test_matrix.data(), symmetric);
+	// the weights are small enough for int16_t to be provably safe
+	const bool narrow = 5 * std::max(1, n) * max_weight < 16383;
+	// with negative weights, the unreachable pairs are INF plus a sum of negative weights depending on the order of the updates
+	bool ok = !narrow || value_bytes <= 2;
+	for (size_t i = 0; i < test_matrix.size(); i++) ok = ok && (test_matrix[i] == correct_matrix[i] ||
+		(negative && test_matrix[i] > INF / 2 && correct_matrix[i] > INF / 2));
+	if (!ok) {
+		printf("\n%s FAILED: n = %d, max_weight = %lld%s%s, solved in %d bytes\n", adaptive_floyd_warshall<T>::get_description().c_str(),
+			n, (long long) max_weight, negative ? " negative" : "", symmetric ? " symmetric" : "", value_bytes);
+		return false;
+	}
+	return true;
+}
+template<typename T> bool test_all_adaptive(Random &random) {
+	printf("Testing adaptive precision with %s... ", vectorize::type_to_str<T>().c_str());
+	for (int t = 0; t < 200; t++) {
+		const int n = random.rnd_int(0, t < 190 ? 70 : 300);
+		// the symmetric graphs with negative weights have negative cycles
+		const bool negative = random.rnd_int(0, 1), symmetric = !negative && random.rnd_int(0, 1);
+		if (!test_adaptive<T>(random, n, negative, symmetric)) return false;
+	}
+	puts("OK");
+	return true;
+}
+
 int main() {
+	printf("Running on %s\n", vectorize::inst_set_to_str(vectorize::best_inst_set()).c_str());
 	Random random;
+	if (!test_all_incremental<int64_t>(random)) return 1;
+	if (!test_all_incremental<int32_t>(random)) return 1;
+	if (!test_all_incremental<int16_t>(random)) return 1;
+	if (!test_all_incremental<double >(random)) return 1;
+	if (!test_all_incremental<float  >(random)) return 1;
+	if (!test_all_min_plus_multiply<int64_t >(random)) return 1;
+	if (!test_all_min_plus_multiply<int32_t >(random)) return 1;
+	if (!test_all_min_plus_multiply<int16_t >(random)) return 1;
+	if (!test_all_min_plus_multiply<double  >(random)) return 1;
+	if (!test_all_min_plus_multiply<float   >(random)) return 1;
+	if (!test_all_min_plus_multiply<uint16_t>(random)) return 1;
+	if (!test_all_min_plus_multiply<uint8_t >(random)) return 1;
+	if (!test_all_semirings<int64_t >(random)) return 1;
+	if (!test_all_semirings<int32_t >(random)) return 1;
+	if (!test_all_semirings<int16_t >(random)) return 1;
+	if (!test_all_semirings<double  >(random)) return 1;
+	if (!test_all_semirings<float   >(random)) return 1;
+	if (!test_all_semirings<uint16_t>(random)) return 1;
+	if (!test_all_semirings<uint8_t >(random)) return 1;
+	if (!test_all_adaptive<int64_t>(random)) return 1;
+	if (!test_all_adaptive<int32_t>(random)) return 1;
 	for (int symmetric = 0; symmetric < 2; symmetric++) {
 		if (!test_all_with_standard_parameters<int64_t>(random, symmetric, GraphType::RANDOM_DENSE)) return 1;
 		if (!test_all_with_standard_parameters<int32_t>(random, symmetric, GraphType::RANDOM_DENSE)) return 1;
 		if (!test_all_with_standard_parameters<int16_t>(random, symmetric, GraphType::RANDOM_DENSE)) return 1;
+		if (!test_all_with_standard_parameters<double >(random, symmetric, GraphType::RANDOM_DENSE)) return 1;
+		if (!test_all_with_standard_parameters<float  >(random, symmetric, GraphType::RANDOM_DENSE)) return 1;
+		if (!test_all_with_standard_parameters<uint16_t>(random, symmetric, GraphType::RANDOM_DENSE)) return 1;
+		if (!test_all_with_standard_parameters<uint8_t >(random, symmetric, GraphType::RANDOM_DENSE)) return 1;
 		
 		if (!test_all_with_standard_parameters<int64_t>(random, symmetric, GraphType::RANDOM_PATH)) return 1;
 		if (!test_all_with_standard_parameters<int32_t>(random, symmetric, GraphType::RANDOM_PATH)) return 1;
 		if (!test_all_with_standard_parameters<int16_t>(random, symmetric, GraphType::RANDOM_PATH)) return 1;
+		if (!test_all_with_standard_parameters<double >(random, symmetric, GraphType::RANDOM_PATH)) return 1;
+		if (!test_all_with_standard_parameters<float  >(random, symmetric, GraphType::RANDOM_PATH)) return 1;
+		if (!test_all_with_standard_parameters<uint16_t>(random, symmetric, GraphType::RANDOM_PATH)) return 1;
+		if (!test_all_with_standard_parameters<uint8_t >(random, symmetric, GraphType::RANDOM_PATH)) return 1;
 		
 		if (!test_all_with_standard_parameters<int64_t>(random, symmetric, GraphType::MAX_PATH)) return 1;
 		if (!test_all_with_standard_parameters<int32_t>(random, symmetric, GraphType::MAX_PATH)) return 1;
 		if (!test_all_with_standard_parameters<int16_t>(random, symmetric, GraphType::MAX_PATH)) return 1;
+		if (!test_all_with_standard_parameters<double >(random, symmetric, GraphType::MAX_PATH)) return 1;
+		if (!test_all_with_standard_parameters<float  >(random, symmetric, GraphType::MAX_PATH)) return 1;
+		if (!test_all_with_standard_parameters<uint16_t>(random, symmetric, GraphType::MAX_PATH)) return 1;
+		if (!test_all_with_standard_parameters<uint8_t >(random, symmetric, GraphType::MAX_PATH)) return 1;
+		
+		if (!test_all_with_standard_parameters<int64_t>(random, symmetric, GraphType::SMALL_WEIGHTS)) return 1;
+		if (!test_all_with_standard_parameters<int32_t>(random, symmetric, GraphType::SMALL_WEIGHTS)) return 1;
+		if (!test_all_with_standard_parameters<int16_t>(random, symmetric, GraphType::SMALL_WEIGHTS)) return 1;
+		if (!test_all_with_standard_parameters<double >(random, symmetric, GraphType::SMALL_WEIGHTS)) return 1;
+		if (!test_all_with_standard_parameters<float  >(random, symmetric, GraphType::SMALL_WEIGHTS)) return 1;
+		if (!test_all_with_standard_parameters<uint16_t>(random, symmetric, GraphType::SMALL_WEIGHTS)) return 1;
+		if (!test_all_with_standard_parameters<uint8_t >(random, symmetric, GraphType::SMALL_WEIGHTS)) return 1;
 	}
 	return 0;
 }
@@ -0,0 +1,61 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include "utils.h"
+
+typedef enum {
+	RANDOM_DENSE,
+	RANDOM_PATH,
+	MAX_PATH,
+	SMALL_WEIGHTS
+} GraphType;
+inline std::string graph_type_to_str(GraphType graph_type) {
+	if (graph_type == GraphType::RANDOM_DENSE) return "RANDOM_DENSE";
+	if (graph_type == GraphType::RANDOM_PATH ) return "RANDOM_PATH";
+	if (graph_type == GraphType::MAX_PATH    ) return "MAX_PATH";
+	if (graph_type == GraphType::SMALL_WEIGHTS) return "SMALL_WEIGHTS";
+	return "";
+}
+/*
+	n * n adjacency matrix(INF for no edge) of a random graph used by the tests and the benchmark:
+	 - RANDOM_DENSE : an edge with a random weight between every pair(including the diagonal)
+	 - RANDOM_PATH  : a single path through all the vertices in a random order with random weights
+	 - MAX_PATH     : the same path with the maximum weight on every edge, so that the distances get as large as the tests allow
+	 - SMALL_WEIGHTS: edges of weights in [0, 3] at a random density, so that many shortest paths tie and some cycles weigh 0
+	The edges go both ways with the same weights if symmetric
+*/
+template<typename T> std::vector<T> generate_graph(Random &random, int n, bool symmetric, GraphType graph_type, T INF) {
+	std::vector<T> matrix;
+	// the sums saturate at INF with unsigned types, so long paths are allowed and become INF
+	T MAX_UNIFORM_WEIGHT = std::is_unsigned<T>::value ? INF / 8 : max_total_weight<T>() / std::max(1, n - 1);
+	if (graph_type == GraphType::RANDOM_DENSE) {
+		matrix.assign((size_t) n * n, 0);
+		if (symmetric) {
+			for (int i = 0; i < n; i++) for (int j = 0; j < i; j++)
+				matrix[(size_t) i * n + j] = matrix[(size_t) j * n + i] = random.rnd_int(1, MAX_UNIFORM_WEIGHT);
+		} else {
+			for (int i = 0; i < n; i++) for (int j = 0; j < n; j++)
+				matrix[(size_t) i * n + j] = random.rnd_int(1, MAX_UNIFORM_WEIGHT);
+		}
+	} else if (graph_type == GraphType::RANDOM_PATH || graph_type == GraphType::MAX_PATH) {
+		matrix.assign((size_t) n * n, INF);
+		std::vector<int> perm(n);
+		std::iota(perm.begin(), perm.end(), 0);
+		for (int i = 1; i < n; i++) std::swap(perm[random.rnd_int(0, i)], perm[i]);
+		for (int i = 0; i + 1 < n; i++) {
+			matrix[(size_t) perm[i] * n + perm[i + 1]] = graph_type == GraphType::RANDOM_PATH ?
+				random.rnd_int(1, MAX_UNIFORM_WEIGHT) : MAX_UNIFORM_WEIGHT;
+			if (symmetric) matrix[(size_t) perm[i + 1] * n + perm[i]] = matrix[(size_t) perm[i] * n + perm[i + 1]];
+		}
+	} else if (graph_type == GraphType::SMALL_WEIGHTS) {
+		matrix.assign((size_t) n * n, INF);
+		const int density_percent = random.rnd_int(1, 100);
+		for (int i = 0; i < n; i++) for (int j = symmetric ? i : 0; j < n; j++) if (random.rnd_int(1, 100) <= density_percent) {
+			matrix[(size_t) i * n + j] = random.rnd_int(0, 3);
+			if (symmetric) matrix[(size_t) j * n + i] = matrix[(size_t) i * n + j];
+		}
+	}
+	return matrix;
+}
@@ -1,4 +1,7 @@
 #pragma once
+#include <cstdint>
+#include <limits>
+#include <type_traits>
 #include <random>
 #include <chrono>
 
@@ -18,3 +21,8 @@ struct Timer {
 		return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1000000.0;
 	}
 };
+
+// upper bound of the total weight of the paths in the tests: less than INF, and exact in floating-point types as long as the weights are integers
+template<typename T> int64_t max_total_weight() {
+	return std::is_floating_point<T>::value ? ((int64_t) 1 << std::numeric_limits<T>::digits) - 1 : std::numeric_limits<T>::max() / 2 - 1;
+}